@@ -0,0 +1,511 @@
+/* arrayops.cc -- Lower D array operations to GCC vector code.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+GCC is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+GCC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GCC; see the file COPYING3.  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include "config.h"
+#include "system.h"
+#include "coretypes.h"
+
+#include "dfrontend/declaration.h"
+#include "dfrontend/expression.h"
+#include "dfrontend/id.h"
+#include "dfrontend/statement.h"
+#include "dfrontend/visitor.h"
+
+#include "tree.h"
+#include "fold-const.h"
+#include "stor-layout.h"
+#include "target.h"
+#include "optabs-tree.h"
+#include "optabs-query.h"
+#include "function.h"
+
+#include "d-tree.h"
+
+
+/* The front-end lowers an array operation such as `a[] = b[] * c[] + d' to
+   a call to a generated function whose body is a scalar loop over the
+   elements of the destination:
+
+	foreach (p; 0 .. p0.length)
+	  p0[p] = cast(int)(p1[p] * p2[p] + c3);
+	return p0;
+
+   Whether that loop gets vectorized is then up to the middle-end, which
+   often gives up as it can't tell that the slices don't overlap.  Instead,
+   when the element type has a vector mode that the target can do all the
+   operations in, the body is built here as a loop over whole vectors,
+   guarded by a run-time check that no operand overlaps the destination in
+   a way that would change the result.  The remaining elements, or all of
+   them if the check fails, are done by a scalar loop.  */
+
+struct arrayop_info
+{
+  /* The variable indexing each slice in the loop body.  */
+  VarDeclaration *key;
+
+  /* The element type of the destination.  */
+  tree elemtype;
+
+  /* The vector type to build, or NULL_TREE for the scalar loop.  */
+  tree vectype;
+
+  /* The index of the element, or first element of the vector.  */
+  tree index;
+
+  /* The slices read by the operation.  */
+  vec<tree> operands;
+};
+
+/* Finds the expression evaluated for each element in the body of an array
+   operation function.  */
+
+class ArrayOpBodyVisitor : public Visitor
+{
+  using Visitor::visit;
+
+public:
+  Expression *exp;
+  bool invalid;
+
+  ArrayOpBodyVisitor (void)
+    : exp (NULL), invalid (false)
+  {
+  }
+
+  void visit (Statement *)
+  {
+  }
+
+  void visit (CompoundStatement *s)
+  {
+    if (s->statements == NULL)
+      return;
+
+    for (size_t i = 0; i < s->statements->dim; i++)
+      {
+	Statement *statement = (*s->statements)[i];
+
+	if (statement != NULL)
+	  statement->accept (this);
+      }
+  }
+
+  void visit (ScopeStatement *s)
+  {
+    if (s->statement)
+      s->statement->accept (this);
+  }
+
+  void visit (ForStatement *s)
+  {
+    if (s->_body)
+      s->_body->accept (this);
+  }
+
+  void visit (ExpStatement *s)
+  {
+    Expression *e = s->exp;
+
+    if (e == NULL || e->op == TOKdeclaration)
+      return;
+
+    if (this->exp != NULL
+	|| (e->op != TOKassign && !isBinAssignArrayOp (e->op))
+	|| ((BinExp *) e)->e1->op != TOKindex)
+      this->invalid = true;
+    else
+      this->exp = e;
+  }
+};
+
+/* Returns TRUE if the target can do CODE on vectors of type VECTYPE.  */
+
+static bool
+vector_op_supported_p (tree_code code, tree vectype)
+{
+  optab op = optab_for_tree_code (code, vectype, optab_default);
+  return (op != unknown_optab
+	  && optab_handler (op, TYPE_MODE (vectype)) != CODE_FOR_nothing);
+}
+
+/* Returns the tree code for the array operation OP on elements of type TYPE,
+   or ERROR_MARK if it can't be done in a vector.  */
+
+static tree_code
+arrayop_tree_code (TOK op, Type *type)
+{
+  switch (op)
+    {
+    case TOKadd:
+    case TOKaddass:
+      return PLUS_EXPR;
+
+    case TOKmin:
+    case TOKminass:
+      return MINUS_EXPR;
+
+    case TOKmul:
+    case TOKmulass:
+      return MULT_EXPR;
+
+    case TOKdiv:
+    case TOKdivass:
+      return type->isfloating () ? RDIV_EXPR : ERROR_MARK;
+
+    case TOKand:
+    case TOKandass:
+      return type->isintegral () ? BIT_AND_EXPR : ERROR_MARK;
+
+    case TOKor:
+    case TOKorass:
+      return type->isintegral () ? BIT_IOR_EXPR : ERROR_MARK;
+
+    case TOKxor:
+    case TOKxorass:
+      return type->isintegral () ? BIT_XOR_EXPR : ERROR_MARK;
+
+    case TOKneg:
+      return NEGATE_EXPR;
+
+    case TOKtilde:
+      return type->isintegral () ? BIT_NOT_EXPR : ERROR_MARK;
+
+    default:
+      return ERROR_MARK;
+    }
+}
+
+/* Build a reference to the element, or vector of elements, at the current
+   index of the slice E.  If CHECKP, the index is checked against the length
+   of the slice.  Returns NULL_TREE if E is not indexed by the loop key.  */
+
+static tree
+build_arrayop_index (IndexExp *e, arrayop_info *info, bool checkp)
+{
+  if (e->e2->op != TOKvar || ((VarExp *) e->e2)->var != info->key)
+    return NULL_TREE;
+
+  if (e->e1->op != TOKvar || e->e1->type->toBasetype ()->ty != Tarray)
+    return NULL_TREE;
+
+  tree array = build_expr (e->e1);
+  tree index = info->index;
+
+  if (checkp)
+    {
+      info->operands.safe_push (array);
+
+      if (info->vectype == NULL_TREE)
+	index = build_bounds_condition (e->loc, index,
+					d_array_length (array), false);
+    }
+
+  tree ptr = build_array_index (d_array_ptr (array), index);
+
+  /* Vectors are only as aligned as the elements they are loaded from.  */
+  tree type = info->elemtype;
+  if (info->vectype != NULL_TREE)
+    type = build_aligned_type (info->vectype, TYPE_ALIGN (info->elemtype));
+
+  return indirect_ref (type, ptr);
+}
+
+/* Build the value of the array operation E for the element, or vector of
+   elements, at the current index.  Returns NULL_TREE if E can't be done
+   in the type being built.  */
+
+static tree
+build_arrayop_elem (Expression *e, arrayop_info *info)
+{
+  if (TYPE_MAIN_VARIANT (build_ctype (e->type)) != info->elemtype)
+    return NULL_TREE;
+
+  tree type = info->vectype ? info->vectype : info->elemtype;
+
+  switch (e->op)
+    {
+    case TOKindex:
+      return build_arrayop_index ((IndexExp *) e, info, true);
+
+    case TOKvar:
+    case TOKint64:
+    case TOKfloat64:
+      {
+	/* The scalar operands are the same for every element.  */
+	if (e->op == TOKvar && !((VarExp *) e)->var->isParameter ())
+	  return NULL_TREE;
+
+	tree value = d_convert (info->elemtype, build_expr (e));
+	if (info->vectype != NULL_TREE)
+	  value = build_vector_from_val (info->vectype, value);
+
+	return value;
+      }
+
+    case TOKcast:
+      /* Only casts to the same type get this far.  */
+      return build_arrayop_elem (((CastExp *) e)->e1, info);
+
+    case TOKneg:
+    case TOKtilde:
+      {
+	tree_code code = arrayop_tree_code (e->op, e->type);
+	if (code == ERROR_MARK)
+	  return NULL_TREE;
+
+	if (info->vectype && !vector_op_supported_p (code, info->vectype))
+	  return NULL_TREE;
+
+	tree arg = build_arrayop_elem (((UnaExp *) e)->e1, info);
+	if (arg == NULL_TREE)
+	  return NULL_TREE;
+
+	return fold_build1 (code, type, arg);
+      }
+
+    default:
+      {
+	if (!isBinArrayOp (e->op))
+	  return NULL_TREE;
+
+	tree_code code = arrayop_tree_code (e->op, e->type);
+	if (code == ERROR_MARK)
+	  return NULL_TREE;
+
+	if (info->vectype && !vector_op_supported_p (code, info->vectype))
+	  return NULL_TREE;
+
+	tree arg0 = build_arrayop_elem (((BinExp *) e)->e1, info);
+	tree arg1 = build_arrayop_elem (((BinExp *) e)->e2, info);
+	if (arg0 == NULL_TREE || arg1 == NULL_TREE)
+	  return NULL_TREE;
+
+	return fold_build2 (code, type, arg0, arg1);
+      }
+    }
+}
+
+/* Build the assignment done by the array operation E for the element, or
+   vector of elements, at the current index.  Returns NULL_TREE if E can't
+   be done in the type being built.  */
+
+static tree
+build_arrayop_assign (BinExp *e, arrayop_info *info)
+{
+  tree lhs = build_arrayop_index ((IndexExp *) e->e1, info, false);
+  if (lhs == NULL_TREE)
+    return NULL_TREE;
+
+  if (e->op == TOKassign)
+    {
+      tree rhs = build_arrayop_elem (e->e2, info);
+      if (rhs == NULL_TREE)
+	return NULL_TREE;
+
+      return modify_expr (lhs, rhs);
+    }
+
+  tree_code code = arrayop_tree_code (e->op, e->e1->type);
+  if (code == ERROR_MARK)
+    return NULL_TREE;
+
+  if (info->vectype && !vector_op_supported_p (code, info->vectype))
+    return NULL_TREE;
+
+  tree rhs = build_arrayop_elem (e->e2, info);
+  if (rhs == NULL_TREE)
+    return NULL_TREE;
+
+  lhs = stabilize_reference (lhs);
+  return modify_expr (lhs, fold_build2 (code, TREE_TYPE (lhs), lhs, rhs));
+}
+
+/* Build a loop doing the assignment E while at least STEP elements are
+   left before LENGTH, adding STEP to the index after each iteration.  */
+
+static tree
+build_arrayop_loop (BinExp *e, arrayop_info *info, tree length, tree step)
+{
+  push_stmt_list ();
+
+  /* Exit logic for the loop.
+	if (index + step > length) break;  */
+  tree t = fold_build2 (PLUS_EXPR, size_type_node, info->index, step);
+  t = build_boolop (GT_EXPR, t, length);
+  add_stmt (build1 (EXIT_EXPR, void_type_node, t));
+
+  t = build_arrayop_assign (e, info);
+  if (t == NULL_TREE)
+    {
+      pop_stmt_list ();
+      return NULL_TREE;
+    }
+  add_stmt (t);
+
+  /* Move to the next element.
+	index += step;  */
+  t = fold_build2 (PLUS_EXPR, size_type_node, info->index, step);
+  add_stmt (modify_expr (info->index, t));
+
+  tree body = pop_stmt_list ();
+  return build1 (LOOP_EXPR, void_type_node, body);
+}
+
+/* Build the condition for running the vector loop over the destination
+   DEST of LENGTH elements, given the OPERANDS read.  Returns NULL_TREE if
+   there is nothing to check.  */
+
+static tree
+build_arrayop_noalias (tree dest, tree length, vec<tree> operands)
+{
+  tree ptrtype = TREE_TYPE (d_array_ptr (dest));
+  tree elemsize = TYPE_SIZE_UNIT (TREE_TYPE (ptrtype));
+  tree dptr = d_convert (size_type_node, d_array_ptr (dest));
+  tree size = size_mult_expr (length, elemsize);
+  tree cond = NULL_TREE;
+
+  for (size_t i = 0; i < operands.length (); i++)
+    {
+      tree array = operands[i];
+
+      /* Each element is read before it is written over, so an operand that
+	 starts at or after the destination gives the same result as the
+	 scalar loop.  Otherwise they must not overlap.
+	     (optr >= dptr || optr + size <= dptr)  */
+      tree optr = d_convert (size_type_node, d_array_ptr (array));
+      tree oend = fold_build2 (PLUS_EXPR, size_type_node, optr, size);
+      tree t = build_boolop (TRUTH_ORIF_EXPR,
+			     build_boolop (GE_EXPR, optr, dptr),
+			     build_boolop (LE_EXPR, oend, dptr));
+
+      /* Leave out of range operands to the scalar loop to report.  */
+      if (array_bounds_check ())
+	t = build_boolop (TRUTH_ANDIF_EXPR, t,
+			  build_boolop (GE_EXPR, d_array_length (array),
+					length));
+
+      cond = cond ? build_boolop (TRUTH_ANDIF_EXPR, cond, t) : t;
+    }
+
+  return cond;
+}
+
+/* Build the body of the array operation function FD as a loop over vectors
+   of its element type.  Returns FALSE if the front-end's loop should be
+   used instead.  */
+
+bool
+build_vector_arrayop (FuncDeclaration *fd)
+{
+  gcc_assert (fd->isArrayOp);
+
+  if (fd->fbody == NULL)
+    return false;
+
+  ArrayOpBodyVisitor v;
+  fd->fbody->accept (&v);
+
+  if (v.exp == NULL || v.invalid)
+    return false;
+
+  BinExp *e = (BinExp *) v.exp;
+  IndexExp *ie = (IndexExp *) e->e1;
+
+  if (ie->e1->op != TOKvar || ie->e2->op != TOKvar)
+    return false;
+
+  VarDeclaration *key = ((VarExp *) ie->e2)->var->isVarDeclaration ();
+  Declaration *dest = ((VarExp *) ie->e1)->var;
+  Type *tdest = dest->type->toBasetype ();
+
+  if (key == NULL || key->ident != Id::p || !dest->isParameter ()
+      || tdest->ty != Tarray)
+    return false;
+
+  /* The destination is returned.  */
+  tree fndecl = get_symbol_decl (fd);
+  tree restype = TREE_TYPE (DECL_RESULT (fndecl));
+
+  if (TYPE_MAIN_VARIANT (restype) != TYPE_MAIN_VARIANT (build_ctype (tdest)))
+    return false;
+
+  /* Only numeric types with a vector mode.  */
+  tree elemtype = TYPE_MAIN_VARIANT (build_ctype (tdest->nextOf ()));
+
+  if (TREE_CODE (elemtype) != INTEGER_TYPE
+      && TREE_CODE (elemtype) != REAL_TYPE)
+    return false;
+
+  machine_mode vmode = targetm.vectorize.preferred_simd_mode
+    (as_a <scalar_mode> (TYPE_MODE (elemtype)));
+
+  if (!VECTOR_MODE_P (vmode))
+    return false;
+
+  arrayop_info info;
+  info.key = key;
+  info.elemtype = elemtype;
+  info.vectype = build_vector_type_for_mode (elemtype, vmode);
+  info.operands = vNULL;
+
+  tree array = get_decl_tree (dest);
+  tree length = build_local_temp (size_type_node);
+  info.index = build_local_temp (size_type_node);
+
+  push_stmt_list ();
+  add_stmt (build_assign (INIT_EXPR, length, d_array_length (array)));
+  add_stmt (build_assign (INIT_EXPR, info.index,
+			 build_zero_cst (size_type_node)));
+
+  /* The vector loop.  */
+  tree step = build_int_cst (size_type_node,
+			    TYPE_VECTOR_SUBPARTS (info.vectype));
+  tree vloop = build_arrayop_loop (e, &info, length, step);
+  tree sloop = NULL_TREE;
+
+  if (vloop != NULL_TREE)
+    {
+      tree cond = build_arrayop_noalias (array, length, info.operands);
+      if (cond != NULL_TREE)
+	vloop = build_vcondition (cond, vloop, void_node);
+
+      add_stmt (vloop);
+
+      /* The scalar loop for the remaining elements.  */
+      info.vectype = NULL_TREE;
+      info.operands.truncate (0);
+      sloop = build_arrayop_loop (e, &info, length,
+				  build_one_cst (size_type_node));
+    }
+
+  info.operands.release ();
+
+  if (sloop == NULL_TREE)
+    {
+      pop_stmt_list ();
+      return false;
+    }
+
+  add_stmt (sloop);
+
+  /* return p0;  */
+  tree result = build_assign (INIT_EXPR, DECL_RESULT (fndecl), array);
+  add_stmt (return_expr (result));
+
+  add_stmt (pop_stmt_list ());
+  return true;
+}
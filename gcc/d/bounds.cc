@@ -0,0 +1,1114 @@
+/* bounds.cc -- Remove array bounds checks that are known to pass.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+GCC is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+GCC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GCC; see the file COPYING3.  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include "config.h"
+#include "system.h"
+#include "coretypes.h"
+
+#include "dfrontend/declaration.h"
+#include "dfrontend/expression.h"
+#include "dfrontend/globals.h"
+#include "dfrontend/init.h"
+#include "dfrontend/intrange.h"
+#include "dfrontend/statement.h"
+#include "dfrontend/visitor.h"
+
+#include "tree.h"
+#include "options.h"
+#include "function.h"
+
+#include "d-tree.h"
+#include "d-frontend.h"
+
+
+/* The front-end only removes bounds checks on indexes whose range it can
+   work out from the expression alone.  Here a few more are removed during
+   code generation, using what is known about local variables that are
+   never changed behind our back:
+
+   - The body of `for (...; key < array.length; ...)' where neither KEY nor
+     ARRAY are changed in the body.  This is what `foreach' over an array
+     or over `0 .. array.length' is lowered to.
+
+   - The statements following one that indexed ARRAY[KEY] unconditionally,
+     up to the next statement that is not straight-line code, as long as
+     neither KEY nor ARRAY are changed in between.
+
+   - Slices of ARRAY whose bounds are ARRAY.length, or whose range the
+     front-end can work out.
+
+   Each of these is recorded as a bounds_fact: that the value of KEY as a
+   size_t is less than the length of ARRAY, or less than LIMIT if ARRAY is
+   NULL.  */
+
+struct bounds_fact
+{
+  VarDeclaration *key;
+  VarDeclaration *array;
+  dinteger_t limit;
+};
+
+/* What is known about the function currently being compiled.  */
+
+struct d_bounds_info
+{
+  /* Whether the function body has been scanned yet.  */
+  bool scanned;
+
+  /* Whether the function has statements that can't be analysed.  */
+  bool unknown;
+
+  /* Variables whose address is taken, or are bound to a reference.  */
+  hash_set<VarDeclaration *> escaped;
+
+  /* Labels that are the target of a goto.  */
+  hash_set<Statement *> targets;
+
+  /* Facts that hold inside the loops being compiled.  */
+  vec<bounds_fact> loop_facts;
+
+  /* Facts established by the preceding statements.  */
+  vec<bounds_fact> checked;
+
+  d_bounds_info (void)
+    : scanned (false), unknown (false), loop_facts (vNULL), checked (vNULL)
+  {
+  }
+
+  ~d_bounds_info (void)
+  {
+    this->loop_facts.release ();
+    this->checked.release ();
+  }
+};
+
+/* Return the bounds information for the current function.  */
+
+static d_bounds_info *
+get_bounds_info (void)
+{
+  if (d_function_chain->bounds == NULL)
+    d_function_chain->bounds = new d_bounds_info;
+
+  return d_function_chain->bounds;
+}
+
+/* Add to SET the variables that the lvalue E is stored in.  */
+
+static void
+add_lvalue_vars (Expression *e, hash_set<VarDeclaration *> &set)
+{
+  switch (e->op)
+    {
+    case TOKvar:
+      if (VarDeclaration *vd = ((VarExp *) e)->var->isVarDeclaration ())
+	set.add (vd);
+      break;
+
+    case TOKarraylength:
+    case TOKcast:
+    case TOKdotvar:
+      add_lvalue_vars (((UnaExp *) e)->e1, set);
+      break;
+
+    case TOKindex:
+    case TOKslice:
+      /* Static arrays are stored in the variable, dynamic arrays aren't.  */
+      if (((UnaExp *) e)->e1->type->toBasetype ()->ty == Tsarray)
+	add_lvalue_vars (((UnaExp *) e)->e1, set);
+      break;
+
+    case TOKcomma:
+      add_lvalue_vars (((CommaExp *) e)->e2, set);
+      break;
+
+    case TOKquestion:
+      add_lvalue_vars (((CondExp *) e)->e1, set);
+      add_lvalue_vars (((CondExp *) e)->e2, set);
+      break;
+
+    default:
+      break;
+    }
+}
+
+/* Walks all statements and expressions in a tree, recording the variables
+   that are assigned to, declared, or escape, and whether there is anything
+   that couldn't be analysed.  */
+
+class BoundsScanVisitor : public StoppableVisitor
+{
+  FuncDeclaration *func_;
+  hash_set<VarDeclaration *> *escaped_;
+  hash_set<Statement *> *targets_;
+
+public:
+  hash_set<VarDeclaration *> assigned;
+  hash_set<VarDeclaration *> declared;
+  hash_set<Statement *> labels;
+  hash_set<Statement *> cases;
+  hash_set<Statement *> switch_cases;
+
+  BoundsScanVisitor (FuncDeclaration *fd, hash_set<VarDeclaration *> *escaped,
+		     hash_set<Statement *> *targets)
+  {
+    this->func_ = fd;
+    this->escaped_ = escaped;
+    this->targets_ = targets;
+  }
+
+  void scan (Statement *s)
+  {
+    if (s != NULL && !this->stop)
+      walkPostorder (s, this);
+  }
+
+  void scan (Expression *e)
+  {
+    if (e != NULL && !this->stop)
+      walkPostorder (e, this);
+  }
+
+  /* Statements that hold expressions.  */
+
+  void visit (Statement *)
+  {
+  }
+
+  void visit (ExpStatement *s)
+  {
+    this->scan (s->exp);
+  }
+
+  void visit (DoStatement *s)
+  {
+    this->scan (s->condition);
+  }
+
+  void visit (ForStatement *s)
+  {
+    this->scan (s->condition);
+    this->scan (s->increment);
+  }
+
+  void visit (IfStatement *s)
+  {
+    this->scan (s->condition);
+  }
+
+  void visit (SwitchStatement *s)
+  {
+    this->scan (s->condition);
+
+    if (s->cases)
+      {
+	for (size_t i = 0; i < s->cases->dim; i++)
+	  this->switch_cases.add ((*s->cases)[i]);
+      }
+
+    if (s->sdefault)
+      this->switch_cases.add (s->sdefault);
+  }
+
+  void visit (CaseStatement *s)
+  {
+    this->scan (s->exp);
+    this->cases.add (s);
+  }
+
+  void visit (DefaultStatement *s)
+  {
+    this->cases.add (s);
+  }
+
+  void visit (GotoCaseStatement *s)
+  {
+    this->scan (s->exp);
+  }
+
+  void visit (GotoStatement *s)
+  {
+    if (this->targets_ && s->label)
+      this->targets_->add (s->label->statement);
+  }
+
+  void visit (LabelStatement *s)
+  {
+    this->labels.add (s);
+  }
+
+  void visit (ReturnStatement *s)
+  {
+    this->scan (s->exp);
+
+    TypeFunction *tf = (TypeFunction *) this->func_->type;
+    if (s->exp && tf->isref)
+      add_lvalue_vars (s->exp, *this->escaped_);
+  }
+
+  void visit (ThrowStatement *s)
+  {
+    this->scan (s->exp);
+  }
+
+  void visit (SynchronizedStatement *s)
+  {
+    this->scan (s->exp);
+  }
+
+  void visit (WithStatement *s)
+  {
+    this->scan (s->exp);
+    if (s->exp)
+      add_lvalue_vars (s->exp, *this->escaped_);
+  }
+
+  /* These are lowered by the front-end, or can change anything.  */
+
+  void visit (WhileStatement *)
+  {
+    this->stop = true;
+  }
+
+  void visit (ForeachStatement *)
+  {
+    this->stop = true;
+  }
+
+  void visit (ForeachRangeStatement *)
+  {
+    this->stop = true;
+  }
+
+  void visit (ForwardingStatement *)
+  {
+    this->stop = true;
+  }
+
+  void visit (CompileStatement *)
+  {
+    this->stop = true;
+  }
+
+  void visit (AsmStatement *)
+  {
+    this->stop = true;
+  }
+
+  void visit (ExtAsmStatement *)
+  {
+    this->stop = true;
+  }
+
+  /* Expressions that change a variable, or let it be changed elsewhere.  */
+
+  void visit (Expression *)
+  {
+  }
+
+  void visit (AssignExp *e)
+  {
+    add_lvalue_vars (e->e1, this->assigned);
+  }
+
+  void visit (BinAssignExp *e)
+  {
+    add_lvalue_vars (e->e1, this->assigned);
+  }
+
+  void visit (PreExp *e)
+  {
+    add_lvalue_vars (e->e1, this->assigned);
+  }
+
+  void visit (PostExp *e)
+  {
+    add_lvalue_vars (e->e1, this->assigned);
+  }
+
+  void visit (AddrExp *e)
+  {
+    add_lvalue_vars (e->e1, *this->escaped_);
+  }
+
+  void visit (SymOffExp *e)
+  {
+    if (VarDeclaration *vd = e->var->isVarDeclaration ())
+      this->escaped_->add (vd);
+  }
+
+  void visit (DelegateExp *e)
+  {
+    add_lvalue_vars (e->e1, *this->escaped_);
+  }
+
+  void visit (CallExp *e)
+  {
+    /* The `this' of a member function is passed by reference.  */
+    if (e->e1->op == TOKdotvar)
+      add_lvalue_vars (((DotVarExp *) e->e1)->e1, *this->escaped_);
+
+    if (!e->arguments)
+      return;
+
+    Type *tb = e->e1->type ? e->e1->type->toBasetype () : NULL;
+    if (tb && (tb->ty == Tdelegate || tb->ty == Tpointer))
+      tb = tb->nextOf ()->toBasetype ();
+
+    TypeFunction *tf = (tb && tb->ty == Tfunction) ? (TypeFunction *) tb : NULL;
+
+    for (size_t i = 0; i < e->arguments->dim; i++)
+      {
+	Parameter *p = tf ? Parameter::getNth (tf->parameters, i) : NULL;
+
+	if (tf == NULL
+	    || (p && (p->storageClass & (STCref | STCout | STClazy))))
+	  add_lvalue_vars ((*e->arguments)[i], *this->escaped_);
+      }
+  }
+
+  void visit (NewExp *e)
+  {
+    if (!e->arguments)
+      return;
+
+    for (size_t i = 0; i < e->arguments->dim; i++)
+      add_lvalue_vars ((*e->arguments)[i], *this->escaped_);
+  }
+
+  /* The walker doesn't look into declarations, so do it here.  */
+
+  void visit (DeclarationExp *e)
+  {
+    VarDeclaration *vd = e->declaration->isVarDeclaration ();
+    if (vd == NULL)
+      return;
+
+    this->declared.add (vd);
+    if (vd->_init == NULL)
+      return;
+
+    ExpInitializer *ei = vd->_init->isExpInitializer ();
+    if (ei == NULL)
+      return;
+
+    Expression *init = ei->exp;
+    if (init->op == TOKconstruct || init->op == TOKblit)
+      {
+	if (((AssignExp *) init)->e1->op == TOKvar
+	    && ((VarExp *) ((AssignExp *) init)->e1)->var == vd)
+	  init = ((AssignExp *) init)->e2;
+      }
+
+    if (vd->storage_class & (STCref | STCout))
+      add_lvalue_vars (init, *this->escaped_);
+
+    this->scan (init);
+  }
+};
+
+/* Scan the body of the current function for variables that escape.  */
+
+static void
+scan_function_body (d_bounds_info *info)
+{
+  FuncDeclaration *fd = d_function_chain->function;
+  BoundsScanVisitor v (fd, &info->escaped, &info->targets);
+
+  v.scan (fd->fbody);
+  info->unknown = v.stop;
+  info->scanned = true;
+}
+
+/* Returns TRUE if the value of the local variable VD can only be changed
+   by an assignment to it in the current function.  */
+
+static bool
+tracked_var_p (VarDeclaration *vd)
+{
+  if (vd == NULL || d_function_chain == NULL)
+    return false;
+
+  if (vd->isDataseg () || vd->isField ()
+      || (vd->storage_class & (STCref | STCout | STClazy | STCmanifest)))
+    return false;
+
+  FuncDeclaration *fd = d_function_chain->function;
+  if (vd->toParent2 () != fd || vd->nestedrefs.dim)
+    return false;
+
+  d_bounds_info *info = get_bounds_info ();
+  if (!info->scanned)
+    scan_function_body (info);
+
+  return !info->unknown && !info->escaped.contains (vd);
+}
+
+/* If E is a variable converted to size_t, return the variable.  */
+
+static VarDeclaration *
+get_key_var (Expression *e)
+{
+  if (e->type->toBasetype ()->ty != Type::tsize_t->ty)
+    return NULL;
+
+  if (e->op == TOKcast && ((CastExp *) e)->e1->type->isintegral ())
+    e = ((CastExp *) e)->e1;
+
+  if (e->op != TOKvar)
+    return NULL;
+
+  return ((VarExp *) e)->var->isVarDeclaration ();
+}
+
+/* If E is an array variable, return the variable.  */
+
+static VarDeclaration *
+get_array_var (Expression *e)
+{
+  Type *tb = e->type->toBasetype ();
+  if (tb->ty != Tarray && tb->ty != Tsarray)
+    return NULL;
+
+  if (e->op != TOKvar)
+    return NULL;
+
+  return ((VarExp *) e)->var->isVarDeclaration ();
+}
+
+/* Returns the expression VD is initialized with, or NULL.  */
+
+static Expression *
+get_var_init (VarDeclaration *vd)
+{
+  if (vd->_init == NULL)
+    return NULL;
+
+  ExpInitializer *ei = vd->_init->isExpInitializer ();
+  if (ei == NULL)
+    return NULL;
+
+  Expression *init = ei->exp;
+  if (init->op == TOKconstruct || init->op == TOKblit)
+    init = ((AssignExp *) init)->e2;
+
+  return init;
+}
+
+/* Returns the static length of the array VD, or zero if it is dynamic.  */
+
+static dinteger_t
+static_array_length (VarDeclaration *vd)
+{
+  if (vd == NULL)
+    return 0;
+
+  Type *tb = vd->type->toBasetype ();
+  if (tb->ty != Tsarray)
+    return 0;
+
+  return ((TypeSArray *) tb)->dim->toInteger ();
+}
+
+/* Returns TRUE if FACT shows that KEY is less than the length of ARRAY.  */
+
+static bool
+fact_holds_p (const bounds_fact &fact, VarDeclaration *key,
+	      VarDeclaration *array)
+{
+  if (fact.key != key)
+    return false;
+
+  if (fact.array == array)
+    return true;
+
+  /* A bound that is no greater than the length of a static array.  */
+  dinteger_t length = static_array_length (array);
+  if (length == 0)
+    return false;
+
+  if (fact.array == NULL)
+    return fact.limit <= length;
+
+  dinteger_t limit = static_array_length (fact.array);
+  return limit != 0 && limit <= length;
+}
+
+/* Returns the reason KEY is known to be less than the length of ARRAY,
+   or NULL if it isn't.  */
+
+static const char *
+find_bounds_fact (VarDeclaration *key, VarDeclaration *array)
+{
+  if (key == NULL || array == NULL || d_function_chain == NULL
+      || d_function_chain->bounds == NULL)
+    return NULL;
+
+  d_bounds_info *info = d_function_chain->bounds;
+
+  for (size_t i = 0; i < info->loop_facts.length (); i++)
+    {
+      if (fact_holds_p (info->loop_facts[i], key, array))
+	return "loop condition";
+    }
+
+  for (size_t i = 0; i < info->checked.length (); i++)
+    {
+      if (fact_holds_p (info->checked[i], key, array))
+	return "checked before";
+    }
+
+  return NULL;
+}
+
+/* Print whether a bounds check on E was removed, and why.  */
+
+static void
+dump_bounds_check (const Loc &loc, Expression *e, const char *reason)
+{
+  if (!flag_dump_bounds_checks)
+    return;
+
+  if (reason)
+    fprintf (global.stdmsg, "%s: removed bounds check on '%s' (%s)\n",
+	     loc.toChars (), e->toChars (), reason);
+  else
+    fprintf (global.stdmsg, "%s: kept bounds check on '%s'\n",
+	     loc.toChars (), e->toChars ());
+}
+
+/* Returns TRUE if the index in E needs to be checked against the length of
+   the array being indexed.  */
+
+bool
+index_bounds_check_p (IndexExp *e)
+{
+  if (!array_bounds_check ())
+    return false;
+
+  const char *reason = NULL;
+
+  if (e->indexIsInBounds)
+    reason = "index range";
+  else
+    {
+      VarDeclaration *key = get_key_var (e->e2);
+      VarDeclaration *array = get_array_var (e->e1);
+
+      if (tracked_var_p (key)
+	  && (static_array_length (array) || tracked_var_p (array)))
+	reason = find_bounds_fact (key, array);
+    }
+
+  dump_bounds_check (e->loc, e, reason);
+  return reason == NULL;
+}
+
+/* Returns TRUE if E is the length of the array being sliced by S.  */
+
+static bool
+slice_length_p (SliceExp *s, Expression *e)
+{
+  if (s->lengthVar && e->op == TOKvar && ((VarExp *) e)->var == s->lengthVar)
+    return true;
+
+  if (e->op != TOKarraylength)
+    return false;
+
+  VarDeclaration *array = get_array_var (s->e1);
+  Expression *e1 = ((ArrayLengthExp *) e)->e1;
+
+  if (array == NULL || e1->op != TOKvar || ((VarExp *) e1)->var != array
+      || !tracked_var_p (array))
+    return false;
+
+  /* The array could be changed after being evaluated for the slice.  */
+  BoundsScanVisitor v (d_function_chain->function,
+		       &get_bounds_info ()->escaped, NULL);
+  v.scan (s->lwr);
+  v.scan (s->upr);
+
+  return !v.stop && !v.assigned.contains (array);
+}
+
+/* Returns TRUE if the upper bound of the slice E needs to be checked against
+   the length of the array being sliced.  */
+
+bool
+slice_upper_check_p (SliceExp *e)
+{
+  if (!array_bounds_check ())
+    return false;
+
+  const char *reason = NULL;
+
+  if (e->upperIsInBounds)
+    reason = "index range";
+  else if (slice_length_p (e, e->upr))
+    reason = "array length";
+  else
+    {
+      VarDeclaration *array = get_array_var (e->e1);
+      dinteger_t length = array ? static_array_length (array) : 0;
+
+      if (length && getIntRange (e->upr).imax <= SignExtendedNumber (length))
+	reason = "index range";
+      else
+	{
+	  VarDeclaration *key = get_key_var (e->upr);
+
+	  /* KEY < length implies KEY <= length.  */
+	  if (tracked_var_p (key) && (length || tracked_var_p (array)))
+	    reason = find_bounds_fact (key, array);
+	}
+    }
+
+  dump_bounds_check (e->upr->loc, e, reason);
+  return reason == NULL;
+}
+
+/* Returns TRUE if the lower bound of the slice E needs to be checked against
+   the upper bound.  */
+
+bool
+slice_lower_check_p (SliceExp *e)
+{
+  if (!array_bounds_check ())
+    return false;
+
+  const char *reason = NULL;
+
+  if (e->lowerIsLessThanUpper)
+    reason = "index range";
+  else
+    {
+      IntRange lwr = getIntRange (e->lwr);
+      IntRange upr = getIntRange (e->upr);
+
+      if (!lwr.imin.negative && lwr.imax <= upr.imin)
+	reason = "index range";
+      else if (slice_length_p (e, e->upr))
+	{
+	  VarDeclaration *key = get_key_var (e->lwr);
+	  VarDeclaration *array = get_array_var (e->e1);
+
+	  if (tracked_var_p (key))
+	    reason = find_bounds_fact (key, array);
+	}
+    }
+
+  dump_bounds_check (e->lwr->loc, e, reason);
+  return reason == NULL;
+}
+
+/* Returns TRUE if E is an integer constant or a variable declared in
+   INIT, giving the value in LIMIT and the variable in VAR.  */
+
+static bool
+get_limit (Expression *e, BoundsScanVisitor &init, dinteger_t *limit,
+	   VarDeclaration **var)
+{
+  *var = NULL;
+
+  if (e->op == TOKint64)
+    {
+      *limit = e->toInteger ();
+      return true;
+    }
+
+  if (e->op != TOKvar)
+    return false;
+
+  /* The temporary holding the upper bound of a foreach range.  */
+  VarDeclaration *vd = ((VarExp *) e)->var->isVarDeclaration ();
+  if (!tracked_var_p (vd) || !init.declared.contains (vd))
+    return false;
+
+  *var = vd;
+  Expression *value = get_var_init (vd);
+  if (value && value->op == TOKint64)
+    {
+      *limit = value->toInteger ();
+      return true;
+    }
+
+  return value != NULL;
+}
+
+/* If the array variable VD was initialized from another array variable
+   by the loop initializer, return it.  */
+
+static VarDeclaration *
+get_array_alias (VarDeclaration *vd, BoundsScanVisitor &init)
+{
+  if (!init.declared.contains (vd))
+    return NULL;
+
+  Expression *value = get_var_init (vd);
+  if (value == NULL)
+    return NULL;
+
+  if (value->op == TOKslice && !((SliceExp *) value)->lwr)
+    value = ((SliceExp *) value)->e1;
+
+  if (value->op == TOKcast)
+    value = ((CastExp *) value)->e1;
+
+  return get_array_var (value);
+}
+
+/* Called before compiling the body of the loop S, to record what is known
+   from its condition.  Returns the number of facts added, which should be
+   passed to pop_loop_bounds afterwards.  */
+
+size_t
+push_loop_bounds (ForStatement *s)
+{
+  if (!array_bounds_check () || s->condition == NULL
+      || s->condition->op != TOKlt)
+    return 0;
+
+  CmpExp *cond = (CmpExp *) s->condition;
+  VarDeclaration *key = get_key_var (cond->e1);
+  if (!tracked_var_p (key))
+    return 0;
+
+  d_bounds_info *info = get_bounds_info ();
+  FuncDeclaration *fd = d_function_chain->function;
+
+  /* Look at everything that happens in the loop, and its initializer.  */
+  BoundsScanVisitor init (fd, &info->escaped, NULL);
+  init.scan (s->_init);
+
+  BoundsScanVisitor loop (fd, &info->escaped, NULL);
+  loop.scan (s->condition);
+  loop.scan (s->_body);
+
+  /* Only the key may be changed by the increment.  */
+  BoundsScanVisitor step (fd, &info->escaped, NULL);
+  step.scan (s->increment);
+
+  if (init.stop || loop.stop || step.stop)
+    return 0;
+
+  /* Jumps into the loop body could skip the condition.  */
+  for (hash_set<Statement *>::iterator it = loop.labels.begin ();
+       it != loop.labels.end (); ++it)
+    {
+      if (info->targets.contains (*it))
+	return 0;
+    }
+
+  for (hash_set<Statement *>::iterator it = loop.cases.begin ();
+       it != loop.cases.end (); ++it)
+    {
+      if (!loop.switch_cases.contains (*it))
+	return 0;
+    }
+
+  if (loop.assigned.contains (key) || loop.declared.contains (key))
+    return 0;
+
+  /* The array or limit that the key is compared against.  */
+  bounds_fact fact;
+  fact.key = key;
+  fact.array = NULL;
+  fact.limit = 0;
+
+  Expression *bound = cond->e2;
+  VarDeclaration *limitvar = NULL;
+
+  if (bound->op == TOKarraylength)
+    fact.array = get_array_var (((ArrayLengthExp *) bound)->e1);
+  else if (get_limit (bound, init, &fact.limit, &limitvar))
+    {
+      if (init.assigned.contains (limitvar)
+	  || loop.assigned.contains (limitvar)
+	  || step.assigned.contains (limitvar))
+	return 0;
+
+      Expression *value = limitvar ? get_var_init (limitvar) : NULL;
+      if (value && value->op == TOKarraylength)
+	fact.array = get_array_var (((ArrayLengthExp *) value)->e1);
+      else if (value && value->op != TOKint64)
+	return 0;
+    }
+  else
+    return 0;
+
+  if (fact.array)
+    {
+      if (!tracked_var_p (fact.array)
+	  || init.assigned.contains (fact.array)
+	  || loop.assigned.contains (fact.array)
+	  || loop.declared.contains (fact.array)
+	  || (limitvar && step.assigned.contains (fact.array)))
+	return 0;
+    }
+
+  size_t length = info->loop_facts.length ();
+  info->loop_facts.safe_push (fact);
+
+  /* The array copied by `foreach' has the same length as the original
+     for as long as the original isn't changed.  */
+  if (fact.array)
+    {
+      VarDeclaration *orig = get_array_alias (fact.array, init);
+
+      if (orig != NULL
+	  && (static_array_length (orig)
+	      || (tracked_var_p (orig)
+		  && !init.assigned.contains (orig)
+		  && !loop.assigned.contains (orig)
+		  && !step.assigned.contains (orig))))
+	{
+	  bounds_fact alias = fact;
+	  alias.array = orig;
+	  info->loop_facts.safe_push (alias);
+	}
+    }
+
+  /* Copies of the key made in the loop body, such as the index variable
+     declared by `foreach'.  */
+  for (hash_set<VarDeclaration *>::iterator it = loop.declared.begin ();
+       it != loop.declared.end (); ++it)
+    {
+      VarDeclaration *vd = *it;
+      Expression *value = get_var_init (vd);
+
+      if (value == NULL || value->op != TOKvar
+	  || ((VarExp *) value)->var != key
+	  || vd->type->toBasetype ()->ty != key->type->toBasetype ()->ty
+	  || !tracked_var_p (vd) || loop.assigned.contains (vd))
+	continue;
+
+      size_t nfacts = info->loop_facts.length ();
+      for (size_t i = length; i < nfacts; i++)
+	{
+	  bounds_fact copy = info->loop_facts[i];
+	  if (copy.key != key)
+	    continue;
+
+	  copy.key = vd;
+	  info->loop_facts.safe_push (copy);
+	}
+    }
+
+  return info->loop_facts.length () - length;
+}
+
+/* Called after compiling the body of a loop, to remove the COUNT facts
+   added by push_loop_bounds.  */
+
+void
+pop_loop_bounds (size_t count)
+{
+  if (count == 0)
+    return;
+
+  d_bounds_info *info = d_function_chain->bounds;
+  gcc_assert (info->loop_facts.length () >= count);
+  info->loop_facts.truncate (info->loop_facts.length () - count);
+}
+
+/* Collects the array indexes that are always evaluated by an expression
+   that completes normally.  */
+
+class CheckedIndexVisitor : public Visitor
+{
+  vec<bounds_fact> *result_;
+
+public:
+  CheckedIndexVisitor (vec<bounds_fact> *result)
+  {
+    this->result_ = result;
+  }
+
+  void visit (Expression *)
+  {
+  }
+
+  void visit (UnaExp *e)
+  {
+    e->e1->accept (this);
+  }
+
+  void visit (BinExp *e)
+  {
+    e->e1->accept (this);
+    e->e2->accept (this);
+  }
+
+  /* Only the first operand is always evaluated.  */
+
+  void visit (AndAndExp *e)
+  {
+    e->e1->accept (this);
+  }
+
+  void visit (OrOrExp *e)
+  {
+    e->e1->accept (this);
+  }
+
+  void visit (CondExp *e)
+  {
+    e->econd->accept (this);
+  }
+
+  /* Asserts may be compiled out.  */
+
+  void visit (AssertExp *)
+  {
+  }
+
+  void visit (CallExp *e)
+  {
+    e->e1->accept (this);
+
+    if (e->arguments)
+      {
+	for (size_t i = 0; i < e->arguments->dim; i++)
+	  (*e->arguments)[i]->accept (this);
+      }
+  }
+
+  void visit (DeclarationExp *e)
+  {
+    VarDeclaration *vd = e->declaration->isVarDeclaration ();
+    if (vd == NULL)
+      return;
+
+    Expression *value = get_var_init (vd);
+    if (value != NULL)
+      value->accept (this);
+  }
+
+  void visit (IndexExp *e)
+  {
+    e->e1->accept (this);
+    e->e2->accept (this);
+
+    bounds_fact fact;
+    fact.key = get_key_var (e->e2);
+    fact.array = get_array_var (e->e1);
+    fact.limit = 0;
+
+    if (fact.key && fact.array)
+      this->result_->safe_push (fact);
+  }
+};
+
+/* Called after compiling the statement S.  Records the indexes checked by
+   it, and forgets what it may have invalidated.  */
+
+void
+record_bounds_checks (Statement *s)
+{
+  if (d_function_chain == NULL || !array_bounds_check ())
+    return;
+
+  ExpStatement *es = s->isExpStatement ();
+  if (es != NULL && es->exp == NULL)
+    return;
+
+  if (es == NULL)
+    {
+      /* Anything but straight-line code could be jumped into or out of.  */
+      if (!s->isCompoundStatement () && !s->isScopeStatement ()
+	  && d_function_chain->bounds)
+	d_function_chain->bounds->checked.truncate (0);
+
+      return;
+    }
+
+  d_bounds_info *info = get_bounds_info ();
+  BoundsScanVisitor v (d_function_chain->function, &info->escaped, NULL);
+  v.scan (es->exp);
+
+  if (v.stop)
+    {
+      info->checked.truncate (0);
+      return;
+    }
+
+  /* Forget the facts about anything changed by the statement.  */
+  for (size_t i = 0; i < info->checked.length (); )
+    {
+      bounds_fact &fact = info->checked[i];
+      if (v.assigned.contains (fact.key) || v.declared.contains (fact.key)
+	  || v.assigned.contains (fact.array))
+	info->checked.unordered_remove (i);
+      else
+	i++;
+    }
+
+  vec<bounds_fact> indexes = vNULL;
+  CheckedIndexVisitor cv (&indexes);
+  es->exp->accept (&cv);
+
+  for (size_t i = 0; i < indexes.length (); i++)
+    {
+      bounds_fact &fact = indexes[i];
+      if (v.assigned.contains (fact.key) || v.declared.contains (fact.key)
+	  || v.assigned.contains (fact.array)
+	  || !tracked_var_p (fact.key)
+	  || (!static_array_length (fact.array)
+	      && !tracked_var_p (fact.array)))
+	continue;
+
+      if (!find_bounds_fact (fact.key, fact.array))
+	info->checked.safe_push (fact);
+    }
+
+  indexes.release ();
+}
+
+/* Called before compiling the statement S.  */
+
+void
+start_bounds_checks (Statement *s)
+{
+  if (d_function_chain == NULL || d_function_chain->bounds == NULL)
+    return;
+
+  if (!s->isExpStatement () && !s->isCompoundStatement ()
+      && !s->isScopeStatement ())
+    d_function_chain->bounds->checked.truncate (0);
+}
+
+/* Called before compiling a statement that can be reached other than by
+   falling through from the one compiled before it: a branch, a loop body,
+   an exception handler, or a finally body.  */
+
+void
+forget_bounds_checks (void)
+{
+  if (d_function_chain == NULL || d_function_chain->bounds == NULL)
+    return;
+
+  d_function_chain->bounds->checked.truncate (0);
+}
+
+/* Free the bounds information of the current function.  */
+
+void
+finish_bounds_checks (void)
+{
+  delete d_function_chain->bounds;
+  d_function_chain->bounds = NULL;
+}
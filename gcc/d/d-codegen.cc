@@ -47,11 +47,13 @@ get_linemap (const Loc& loc)
 {
   location_t gcc_location = input_location;
 
-  if (loc.filename)
+  if (loc.filename ())
     {
-      linemap_add (line_table, LC_ENTER, 0, loc.filename, loc.linnum);
-      linemap_line_start (line_table, loc.linnum, 0);
-      gcc_location = linemap_position_for_column (line_table, loc.charnum);
+      const char *filename = loc.filename ();
+      unsigned linnum = loc.linnum ();
+      linemap_add (line_table, LC_ENTER, 0, filename, linnum);
+      linemap_line_start (line_table, linnum, 0);
+      gcc_location = linemap_position_for_column (line_table, loc.charnum ());
       linemap_add (line_table, LC_LEAVE, 0, NULL, 0);
     }
 
@@ -461,6 +463,50 @@ build_vindex_ref (tree object, tree fntype, size_t index)
   return build_memref (fntype, result, size_int (Target::ptrsize * index));
 }
 
+/* Build a test of whether the class reference OBJECT, which must not be null,
+   is an instance of the class CD or one of its subclasses.  This is done by
+   looking up the ClassInfo of OBJECT from its vtable.  If CD is final, then
+   that is compared directly against the ClassInfo of CD.  Otherwise CD must
+   appear at its own depth in the list of ancestors of that ClassInfo.  */
+
+tree
+build_class_instanceof (tree object, ClassDeclaration *cd)
+{
+  gcc_assert (!cd->isInterfaceDeclaration () && !cd->isCPPclass ()
+	      && !cd->isCOMclass ());
+
+  tree csym = build_nop (ptr_type_node,
+			 build_address (get_classinfo_decl (cd)));
+
+  /* Generate **object to get the classinfo.  */
+  tree ci = indirect_ref (ptr_type_node, object);
+  ci = indirect_ref (ptr_type_node, ci);
+
+  if (cd->storage_class & STCfinal)
+    return build_boolop (EQ_EXPR, ci, csym);
+
+  size_t depth = 0;
+  for (ClassDeclaration *bcd = cd->baseClass; bcd; bcd = bcd->baseClass)
+    depth++;
+
+  /* The ancestors array is the last field of ClassInfo.  */
+  ci = d_save_expr (ci);
+  tree ancestors = build_offset (ci, size_int (Target::classinfosize
+					       - 2 * Target::ptrsize));
+  ancestors = indirect_ref (build_ctype (Type::tvoidptr->arrayOf ()),
+			    ancestors);
+
+  tree length = d_array_length (ancestors);
+  tree ptr = d_array_ptr (ancestors);
+  tree base = indirect_ref (ptr_type_node,
+			    build_offset (ptr, size_int (depth
+							 * Target::ptrsize)));
+
+  return build_boolop (TRUTH_ANDIF_EXPR,
+		       build_boolop (GT_EXPR, length, size_int (depth)),
+		       build_boolop (EQ_EXPR, base, csym));
+}
+
 /* Return TRUE if EXP is a valid lvalue.  Lvalues references cannot be
    made into temporaries, otherwise any assignments will be lost.  */
 
@@ -891,13 +937,75 @@ build_struct_comparison (tree_code code, StructDeclaration *sd,
   return compound_expr (compound_expr (t1init, t2init), result);
 }
 
+/* Returns TRUE if the equality of two values of type TELEM can be tested
+   inline, either directly or by calling the opEquals of a struct.  */
+
+bool
+elem_comparison_p (Type *telem)
+{
+  if (telem->ty == Tstruct)
+    {
+      /* If the generated __xopEquals has not had its body checked yet, it
+	 may still fail to compile, so leave it to the TypeInfo.  */
+      FuncDeclaration *xeq = ((TypeStruct *) telem)->sym->xeq;
+      if (xeq != NULL && (xeq == StructDeclaration::xerreq
+			  || (xeq->generated
+			      && xeq->semanticRun < PASSsemantic3done)))
+	return false;
+
+      return true;
+    }
+
+  return telem->isintegral () || telem->isfloating ();
+}
+
+/* Build an equality expression between the two values T1 and T2 of type
+   TELEM, calling its opEquals if it is a struct that has one.
+   CODE is the EQ_EXPR or NE_EXPR comparison.  */
+
+static tree
+build_elem_comparison (tree_code code, Type *telem, tree t1, tree t2)
+{
+  if (telem->ty != Tstruct)
+    return build_boolop (code, t1, t2);
+
+  StructDeclaration *sd = ((TypeStruct *) telem)->sym;
+  if (sd->xeq == NULL)
+    return build_struct_comparison (code, sd, t1, t2);
+
+  /* Either `bool opEquals(ref const S) const', or the generated
+     `static bool __xopEquals(ref const S, ref const S)'.  */
+  FuncDeclaration *fd = sd->xeq;
+  TypeFunction *tf = (TypeFunction *) fd->type;
+  tree callee = build_address (get_symbol_decl (fd));
+  tree result;
+
+  record_inline_import (fd);
+
+  if (fd->isThis ())
+    {
+      Parameter *arg = Parameter::getNth (tf->parameters, 0);
+      result = build_call_expr (callee, 2, build_address (t1),
+				convert_for_argument (t2, arg));
+    }
+  else
+    {
+      Parameter *arg1 = Parameter::getNth (tf->parameters, 0);
+      Parameter *arg2 = Parameter::getNth (tf->parameters, 1);
+      result = build_call_expr (callee, 2, convert_for_argument (t1, arg1),
+				convert_for_argument (t2, arg2));
+    }
+
+  return build_boolop (code, result, boolean_true_node);
+}
+
 /* Build an equality expression between two ARRAY_TYPES of size LENGTH.
-   The pointer references are T1 and T2, and the element type is SD.
+   The pointer references are T1 and T2, and the element type is TELEM.
    CODE is the EQ_EXPR or NE_EXPR comparison.  */
 
 tree
-build_array_struct_comparison (tree_code code, StructDeclaration *sd,
-			       tree length, tree t1, tree t2)
+build_array_elem_comparison (tree_code code, Type *telem,
+			     tree length, tree t1, tree t2)
 {
   tree_code tcode = (code == EQ_EXPR) ? TRUTH_ANDIF_EXPR : TRUTH_ORIF_EXPR;
 
@@ -907,8 +1015,8 @@ build_array_struct_comparison (tree_code code, StructDeclaration *sd,
   tree init = build_boolop (code, integer_zero_node, integer_zero_node);
   add_stmt (build_assign (INIT_EXPR, result, init));
 
-  /* Cast pointer-to-array to pointer-to-struct.  */
-  tree ptrtype = build_ctype (sd->type->pointerTo ());
+  /* Cast pointer-to-array to pointer-to-element.  */
+  tree ptrtype = build_ctype (telem->pointerTo ());
   tree lentype = TREE_TYPE (length);
 
   push_binding_level (level_block);
@@ -940,7 +1048,7 @@ build_array_struct_comparison (tree_code code, StructDeclaration *sd,
 
   /* Do comparison, caching the value.
 	result = result OP (*t1 == *t2);  */
-  t = build_struct_comparison (code, sd, build_deref (t1), build_deref (t2));
+  t = build_elem_comparison (code, telem, build_deref (t1), build_deref (t2));
   t = build_boolop (tcode, result, t);
   t = modify_expr (result, t);
   add_stmt (t);
@@ -2049,13 +2157,14 @@ tree
 d_assert_call (const Loc& loc, libcall_fn libcall, tree msg)
 {
   tree file;
-  tree line = size_int (loc.linnum);
+  tree line = size_int (loc.linnum ());
 
   /* File location is passed as a D string.  */
-  if (loc.filename)
+  if (loc.filename ())
     {
-      unsigned len = strlen (loc.filename);
-      tree str = build_string (len + 1, loc.filename);
+      const char *filename = loc.filename ();
+      unsigned len = strlen (filename);
+      tree str = build_string (len + 1, filename);
       TREE_TYPE (str) = make_array_type (Type::tchar, len);
 
       file = d_array_value (build_ctype (Type::tchar->arrayOf ()),
@@ -451,6 +451,25 @@ convert_expr (tree exp, Type *etype, Type *totype)
 	      break;
 	    }
 
+	  /* Casting down the class hierarchy can be done inline, as the offset
+	     is always zero, so only need to check the ClassInfo of the object.
+	     C++ and COM objects need not have a D ClassInfo to check.  */
+	  if (!cdfrom->isInterfaceDeclaration ()
+	      && !cdto->isInterfaceDeclaration ()
+	      && !cdto->isCPPclass () && !cdto->isCOMclass ())
+	    {
+	      tree type = build_ctype (totype);
+	      exp = d_save_expr (exp);
+
+	      tree cond = build_boolop (TRUTH_ANDIF_EXPR,
+					build_boolop (NE_EXPR, exp,
+						      null_pointer_node),
+					build_class_instanceof (exp, cdto));
+
+	      return build_condition (type, cond, build_nop (type, exp),
+				      build_nop (type, null_pointer_node));
+	    }
+
 	  /* The offset can only be determined at runtime, do dynamic cast.  */
 	  libcall_fn libcall = cdfrom->isInterfaceDeclaration ()
 	    ? LIBCALL_INTERFACE_CAST : LIBCALL_DYNAMIC_CAST;
@@ -24,6 +24,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "dfrontend/mtype.h"
 #include "dfrontend/scope.h"
 #include "dfrontend/statement.h"
+#include "dfrontend/stringtable.h"
 #include "dfrontend/target.h"
 
 #include "tree.h"
@@ -99,13 +100,206 @@ Global::increaseErrorCount (void)
 
 
 /* Implements the Loc interface defined by the frontend.
-   Used for keeping track of current file/line position in code.  */
+   Used for keeping track of current file/line position in code.
+
+   A Loc is an offset into the text of every source lexed, so is only four
+   bytes in each token and AST node.  The file, line and column are found
+   by looking the offset up in the table of sources below, which happens
+   only for diagnostics, debug info, and JSON or documentation output.  */
+
+/* A #line directive, or the start of a source.  */
+
+struct loc_directive
+{
+  unsigned line;		/* Index of the line it applies from.  */
+  const char *filename;
+  unsigned linnum;
+};
+
+/* A range of offsets for one source passed to the lexer, or for a single
+   Loc made from an explicit file, line and column.  */
+
+struct loc_source
+{
+  unsigned start;		/* Offset of the first character.  */
+  unsigned length;		/* Number of offsets reserved.  */
+  int charnum;			/* Column of an explicit Loc, else -1.  */
+  vec<unsigned> lines;		/* Offset of the start of each later line.  */
+  vec<loc_directive> directives;
+};
+
+/* The sources, in order of offset.  Offset 0 is left unused.  */
+
+static vec<loc_source> loc_sources;
+static unsigned loc_next_offset = 1;
+
+/* Explicit Locs already made, keyed on "line:column:file".  */
+
+static StringTable loc_explicit;
+static bool loc_explicit_init = false;
+
+/* The last Loc decoded, and its file, line and column.  */
+
+static unsigned loc_last_offset = 0;
+static loc_directive loc_last_decoded;
+static unsigned loc_last_charnum;
+
+/* Return the index of the source that OFFSET lies in.  */
+
+static unsigned
+loc_find_source (unsigned offset)
+{
+  static unsigned last = 0;
+
+  if (last < loc_sources.length ()
+      && offset >= loc_sources[last].start
+      && offset - loc_sources[last].start < loc_sources[last].length)
+    return last;
+
+  unsigned lo = 0;
+  unsigned hi = loc_sources.length ();
+  while (hi - lo > 1)
+    {
+      unsigned mid = lo + (hi - lo) / 2;
+      if (loc_sources[mid].start <= offset)
+	lo = mid;
+      else
+	hi = mid;
+    }
+
+  last = lo;
+  return lo;
+}
+
+/* Return the number of lines in SRC that start at or before OFFSET, which
+   is the index of the line containing OFFSET.  */
+
+static unsigned
+loc_line_index (const loc_source &src, unsigned offset)
+{
+  unsigned lo = 0;
+  unsigned hi = src.lines.length ();
+  while (lo < hi)
+    {
+      unsigned mid = lo + (hi - lo) / 2;
+      if (src.lines[mid] <= offset)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+/* Reserve LENGTH offsets for a new source, with its first line being
+   LINNUM of FILENAME.  Return the new source.  */
+
+static loc_source &
+loc_add_source (const char *filename, unsigned linnum, size_t length)
+{
+  if (length >= UINT_MAX - loc_next_offset)
+    fatal_error (input_location, "too much source text to track locations");
+
+  loc_source src;
+  src.start = loc_next_offset;
+  src.length = length;
+  src.charnum = -1;
+  src.lines = vNULL;
+  src.directives = vNULL;
+
+  loc_directive d = { 0, filename, linnum };
+  src.directives.safe_push (d);
+
+  loc_next_offset += length;
+  loc_sources.safe_push (src);
+  return loc_sources.last ();
+}
+
+/* Look up the file, line and column of OFFSET, setting the loc_last
+   variables to them.  */
+
+static void
+loc_decode (unsigned offset)
+{
+  if (offset == loc_last_offset)
+    return;
+
+  loc_last_offset = offset;
+  loc_last_decoded.filename = NULL;
+  loc_last_decoded.linnum = 0;
+  loc_last_charnum = 0;
+
+  if (offset == 0 || loc_sources.is_empty ())
+    return;
+
+  const loc_source &src = loc_sources[loc_find_source (offset)];
+  const loc_directive *d = &src.directives[0];
+
+  if (src.charnum >= 0)
+    {
+      loc_last_decoded.filename = d->filename;
+      loc_last_decoded.linnum = d->linnum;
+      loc_last_charnum = src.charnum;
+      return;
+    }
+
+  unsigned line = loc_line_index (src, offset);
+  unsigned linestart = line ? src.lines[line - 1] : src.start;
+
+  for (unsigned i = src.directives.length () - 1; i > 0; i--)
+    {
+      if (src.directives[i].line <= line)
+	{
+	  d = &src.directives[i];
+	  break;
+	}
+    }
+
+  loc_last_decoded.filename = d->filename;
+  loc_last_decoded.linnum = d->linnum + (line - d->line);
+  loc_last_charnum = offset - linestart + 1;
+}
 
 Loc::Loc (const char *filename, unsigned linnum, unsigned charnum)
 {
-  this->linnum = linnum;
-  this->charnum = charnum;
-  this->filename = filename;
+  if (!loc_explicit_init)
+    {
+      loc_explicit._init ();
+      loc_explicit_init = true;
+    }
+
+  OutBuffer buf;
+  buf.printf ("%u:%u:%s", linnum, charnum, filename ? filename : "");
+
+  StringValue *sv = loc_explicit.update (buf.peekString (), buf.offset);
+  if (sv->ptrvalue == NULL)
+    {
+      loc_source &src = loc_add_source (filename, linnum, 1);
+      src.charnum = charnum;
+      sv->ptrvalue = (void *) (size_t) src.start;
+    }
+
+  this->offset = (unsigned) (size_t) sv->ptrvalue;
+}
+
+const char *
+Loc::filename (void) const
+{
+  loc_decode (this->offset);
+  return loc_last_decoded.filename;
+}
+
+unsigned
+Loc::linnum (void) const
+{
+  loc_decode (this->offset);
+  return loc_last_decoded.linnum;
+}
+
+unsigned
+Loc::charnum (void) const
+{
+  loc_decode (this->offset);
+  return loc_last_charnum;
 }
 
 const char *
@@ -113,14 +307,15 @@ Loc::toChars (void) const
 {
   OutBuffer buf;
 
-  if (this->filename)
-    buf.printf ("%s", this->filename);
+  loc_decode (this->offset);
+  if (loc_last_decoded.filename)
+    buf.printf ("%s", loc_last_decoded.filename);
 
-  if (this->linnum)
+  if (loc_last_decoded.linnum)
     {
-      buf.printf (":%u", this->linnum);
-      if (this->charnum)
-	buf.printf (":%u", this->charnum);
+      buf.printf (":%u", loc_last_decoded.linnum);
+      if (loc_last_charnum)
+	buf.printf (":%u", loc_last_charnum);
     }
 
   return buf.extractString ();
@@ -129,15 +324,59 @@ Loc::toChars (void) const
 bool
 Loc::equals (const Loc& loc)
 {
-  if (this->linnum != loc.linnum || this->charnum != loc.charnum)
+  if (this->offset == loc.offset)
+    return true;
+
+  const char *filename = this->filename ();
+  unsigned linnum = this->linnum ();
+  unsigned charnum = this->charnum ();
+
+  if (linnum != loc.linnum () || charnum != loc.charnum ())
     return false;
 
-  if (!FileName::equals (this->filename, loc.filename))
+  if (!FileName::equals (filename, loc.filename ()))
     return false;
 
   return true;
 }
 
+/* Implements the LocTable interface defined by the frontend.
+   Called by the lexer to record the sources and lines that it reads.  */
+
+unsigned
+LocTable::addSource (const char *filename, unsigned linnum, size_t length)
+{
+  return loc_add_source (filename, linnum, length + 1).start;
+}
+
+void
+LocTable::addLine (unsigned offset)
+{
+  loc_source &src = loc_sources[loc_find_source (offset)];
+
+  /* Text that is lexed again adds nothing.  */
+  if (offset <= src.start
+      || (!src.lines.is_empty () && offset <= src.lines.last ()))
+    return;
+
+  src.lines.safe_push (offset);
+  loc_last_offset = 0;
+}
+
+void
+LocTable::addLineDirective (unsigned offset, const char *filename,
+			    unsigned linnum)
+{
+  loc_source &src = loc_sources[loc_find_source (offset)];
+  loc_directive d = { loc_line_index (src, offset) + 1, filename, linnum };
+
+  while (src.directives.length () > 1 && src.directives.last ().line >= d.line)
+    src.directives.pop ();
+
+  src.directives.safe_push (d);
+  loc_last_offset = 0;
+}
+
 
 /* Implements the Port interface defined by the frontend.
    A mini library for doing compiler/system specific things.  */
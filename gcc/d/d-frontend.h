@@ -24,7 +24,10 @@ along with GCC; see the file COPYING3.  If not see
 /* Forward type declarations to avoid including unnecessary headers.  */
 
 class Dsymbol;
+class Expression;
 class FuncDeclaration;
+class Statement;
+class StoppableVisitor;
 class StructDeclaration;
 class Type;
 class Module;
@@ -45,5 +48,11 @@ const char *cppTypeInfoMangleItanium (Dsymbol *);
 
 /* Used in decl.cc.  */
 Expression *initializerToExpression (Initializer *i, Type *t = NULL);
+int inlineCostFunction (FuncDeclaration *fd, bool hasthis, bool hdrscan);
+bool tooCostly (int cost);
+
+/* Used in bounds.cc.  */
+bool walkPostorder (Expression *e, StoppableVisitor *v);
+bool walkPostorder (Statement *s, StoppableVisitor *v);
 
 #endif  /* ! GCC_D_FRONTEND_H */
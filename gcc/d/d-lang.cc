@@ -42,6 +42,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "gimple-expr.h"
 #include "gimplify.h"
 #include "debug.h"
+#include "md5.h"
 
 #include "d-tree.h"
 #include "d-frontend.h"
@@ -65,6 +66,11 @@ struct d_option_data
   OutBuffer *deps_target;           /* -M[QT] <arg> */
   bool deps_phony;                  /* -MP  */
 
+  bool fingerprint;                 /* -ffingerprint  */
+  const char *fingerprint_filename; /* -ffingerprint=<arg>  */
+
+  const char *template_owners;      /* -ftemplate-owners=<arg>  */
+
   bool stdinc;                      /* -nostdinc  */
 }
 d_option;
@@ -86,6 +92,70 @@ static GTY(()) tree global_context;
 /* Array of all global declarations to pass back to the middle-end.  */
 static GTY(()) vec<tree, va_gc> *global_declarations;
 
+/* Front-end phases timed by -ftime-report.  */
+enum d_phase
+{
+  D_PHASE_READ,
+  D_PHASE_PARSE,
+  D_PHASE_IMPORTALL,
+  D_PHASE_SEMANTIC,
+  D_PHASE_SEMANTIC2,
+  D_PHASE_SEMANTIC3,
+  D_PHASE_CODEGEN,
+  D_PHASE_MAX
+};
+
+static const char *d_phase_names[D_PHASE_MAX] =
+{
+  "read", "parse", "importall", "semantic", "semantic2", "semantic3",
+  "codegen"
+};
+
+/* Time spent in each phase, and the phase currently being timed.  */
+static long d_phase_times[D_PHASE_MAX];
+static long d_phase_started;
+static int d_phase_current = -1;
+
+/* Stop timing the current front-end phase, and start timing PHASE.
+   A negative PHASE just stops the clock.  */
+
+static void
+d_switch_phase (int phase)
+{
+  if (!time_report)
+    return;
+
+  long now = get_run_time ();
+
+  if (d_phase_current >= 0)
+    d_phase_times[d_phase_current] += now - d_phase_started;
+
+  d_phase_current = phase;
+  d_phase_started = now;
+}
+
+/* Print the time spent in each front-end phase to stderr.  */
+
+static void
+d_print_phase_times (void)
+{
+  long total = 0;
+
+  for (int i = 0; i < D_PHASE_MAX; i++)
+    total += d_phase_times[i];
+
+  fprintf (stderr, "\nD front-end phases:\n");
+
+  for (int i = 0; i < D_PHASE_MAX; i++)
+    {
+      fprintf (stderr, " %-22s:%7.2f (%3.0f%%)\n", d_phase_names[i],
+	       d_phase_times[i] / 1000000.0,
+	       total ? d_phase_times[i] * 100.0 / total : 0.0);
+    }
+
+  fprintf (stderr, " %-22s:%7.2f\n", "TOTAL", total / 1000000.0);
+}
+
 /* Support for GCC-style command-line make dependency generation.
    Adds TARGET to the make dependencies target buffer.
    QUOTED is true if the string should be quoted.  */
@@ -252,6 +322,58 @@ deps_write (Module *module, OutBuffer *buffer, unsigned colmax = 72)
     }
 }
 
+/* Write the fingerprints of each module in MODULES, being the MD5 hash of
+   the import file that -fintfc would generate for it with the bodies of all
+   functions included.  That covers the declarations, signatures, templates
+   and everything importers can inline or evaluate at compile time, but not
+   unittests, static constructors or destructors, invariants, comments or
+   the layout of the source.  */
+
+static void
+write_fingerprints (Modules &modules)
+{
+  /* The bodies are only written with -finline-functions, but the hashes
+     must not depend on the optimization options.  */
+  bool save_strip = global.params.hdrStripPlainFunctions;
+  global.params.hdrStripPlainFunctions = false;
+
+  OutBuffer out;
+
+  for (size_t i = 0; i < modules.dim; i++)
+    {
+      Module *m = modules[i];
+      if (d_option.fonly && m != Module::rootModule)
+	continue;
+
+      OutBuffer buf;
+      buf.doindent = 1;
+
+      HdrGenState hgs;
+      hgs.hdrgen = true;
+      toCBuffer (m, &buf, &hgs);
+
+      unsigned char digest[16];
+      md5_buffer ((const char *) buf.data, buf.offset, digest);
+
+      for (size_t j = 0; j < sizeof (digest); j++)
+	out.printf ("%02x", digest[j]);
+      out.printf (" %s\n", m->toPrettyChars ());
+    }
+
+  global.params.hdrStripPlainFunctions = save_strip;
+
+  /* The driver derives the file name from the output file given with -o,
+     so this is only used when cc1d is run on its own.  */
+  const char *name = d_option.fingerprint_filename;
+  if (name == NULL)
+    name = FileName::forceExt (FileName::name (main_input_filename), "fp");
+
+  File *ffp = File::create (name);
+  ffp->setbuffer ((void *) out.data, out.offset);
+  out.extractData ();
+  writeFile (Loc (), ffp);
+}
+
 /* Implements the lang_hooks.init_options routine for language D.
    This initializes the global state for the D frontend before calling
    the option handlers.  */
@@ -279,6 +401,7 @@ d_init_options (unsigned int, cl_decoded_option *decoded_options)
   global.params.hdrStripPlainFunctions = true;
   global.params.betterC = false;
   global.params.allInst = false;
+  global.params.mangleBackrefs = false;
 
   global.params.linkswitches = new Strings ();
   global.params.libfiles = new Strings ();
@@ -297,6 +420,9 @@ d_init_options (unsigned int, cl_decoded_option *decoded_options)
   d_option.deps_skip_system = false;
   d_option.deps_filename = NULL;
   d_option.deps_filename_user = NULL;
+  d_option.fingerprint = false;
+  d_option.fingerprint_filename = NULL;
+  d_option.template_owners = NULL;
   d_option.deps_target = NULL;
   d_option.deps_phony = false;
   d_option.stdinc = true;
@@ -471,6 +597,15 @@ d_handle_option (size_t scode, const char *arg, int value,
       global.params.vcg_ast = value;
       break;
 
+    case OPT_ffingerprint:
+      d_option.fingerprint = value;
+      break;
+
+    case OPT_ffingerprint_:
+      d_option.fingerprint = true;
+      d_option.fingerprint_filename = arg;
+      break;
+
     case OPT_fignore_unknown_pragmas:
       global.params.ignoreUnsupportedPragmas = value;
       break;
@@ -493,6 +628,10 @@ d_handle_option (size_t scode, const char *arg, int value,
       global.params.useInvariants = value;
       break;
 
+    case OPT_fmangle_backrefs:
+      global.params.mangleBackrefs = value;
+      break;
+
     case OPT_fmodule_filepath_:
       global.params.modFileAliasStrings->push (arg);
       if (!strchr (arg, '='))
@@ -527,6 +666,10 @@ d_handle_option (size_t scode, const char *arg, int value,
       global.params.useSwitchError = value;
       break;
 
+    case OPT_ftemplate_owners_:
+      d_option.template_owners = arg;
+      break;
+
     case OPT_ftransition_all:
       global.params.vtls = value;
       global.params.vfield = value;
@@ -977,6 +1120,8 @@ d_parse_file (void)
     }
 
   /* Read all D source files.  */
+  d_switch_phase (D_PHASE_READ);
+
   for (size_t i = 0; i < modules.dim; i++)
     {
       Module *m = modules[i];
@@ -984,6 +1129,8 @@ d_parse_file (void)
     }
 
   /* Parse all D source files.  */
+  d_switch_phase (D_PHASE_PARSE);
+
   for (size_t i = 0; i < modules.dim; i++)
     {
       Module *m = modules[i];
@@ -1028,10 +1175,17 @@ d_parse_file (void)
 	}
     }
 
+  /* Like 'header' import files, fingerprints are taken from the parsed source
+     before semantic analysis changes it.  */
+  if (d_option.fingerprint)
+    write_fingerprints (modules);
+
   if (global.errors)
     goto had_errors;
 
   /* Load all unconditional imports for better symbol resolving.  */
+  d_switch_phase (D_PHASE_IMPORTALL);
+
   for (size_t i = 0; i < modules.dim; i++)
     {
       Module *m = modules[i];
@@ -1046,6 +1200,8 @@ d_parse_file (void)
     goto had_errors;
 
   /* Do semantic analysis.  */
+  d_switch_phase (D_PHASE_SEMANTIC);
+
   for (size_t i = 0; i < modules.dim; i++)
     {
       Module *m = modules[i];
@@ -1077,6 +1233,8 @@ d_parse_file (void)
     }
 
   /* Do pass 2 semantic analysis.  */
+  d_switch_phase (D_PHASE_SEMANTIC2);
+
   for (size_t i = 0; i < modules.dim; i++)
     {
       Module *m = modules[i];
@@ -1093,6 +1251,8 @@ d_parse_file (void)
     goto had_errors;
 
   /* Do pass 3 semantic analysis.  */
+  d_switch_phase (D_PHASE_SEMANTIC3);
+
   for (size_t i = 0; i < modules.dim; i++)
     {
       Module *m = modules[i];
@@ -1117,6 +1277,7 @@ d_parse_file (void)
     goto had_errors;
 
   /* Generate output files.  */
+  d_switch_phase (D_PHASE_CODEGEN);
 
   /* Module dependencies (imports, file, version, debug, lib).  */
   if (global.params.moduleDeps)
@@ -1204,6 +1365,21 @@ d_parse_file (void)
 	}
     }
 
+  /* Read which template instances are owned by which modules before deciding
+     what to emit.  */
+  if (d_option.template_owners && !flag_syntax_only)
+    {
+      Modules owners;
+      for (size_t i = 0; i < modules.dim; i++)
+	{
+	  Module *m = modules[i];
+	  if (!d_option.fonly || m == Module::rootModule)
+	    owners.push (m);
+	}
+
+      load_template_owners (d_option.template_owners, owners);
+    }
+
   for (size_t i = 0; i < modules.dim; i++)
     {
       Module *m = modules[i];
@@ -1222,6 +1398,13 @@ d_parse_file (void)
 	}
     }
 
+  /* Compile the bodies of imported functions that may be inlined.  */
+  if (!flag_syntax_only)
+    build_inline_imports ();
+
+  if (flag_dump_typeinfo)
+    dump_typeinfo_stats ();
+
   /* And end the main input file, if the debug writer wants it.  */
   if (debug_hooks->start_end_main_source_file)
     debug_hooks->end_source_file (0);
@@ -1234,6 +1417,16 @@ d_parse_file (void)
   /* Write out globals.  */
   d_finish_compilation (vec_safe_address (global_declarations),
 			vec_safe_length (global_declarations));
+
+  /* Record the template instances claimed by this compilation, unless there
+     were errors and there is no object file to hold them.  */
+  if (d_option.template_owners && !errorcount)
+    save_template_owners (d_option.template_owners);
+
+  d_switch_phase (-1);
+
+  if (time_report)
+    d_print_phase_times ();
 }
 
 /* Implements the lang_hooks.types.type_for_mode routine for language D.  */
@@ -0,0 +1,30 @@
+/* d-opts.h -- Definitions of enumerated values used by D options.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; either version 3, or (at your option) any
+   later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING3.  If not see
+   <http://www.gnu.org/licenses/>.  */
+
+#ifndef GCC_D_OPTS_H
+#define GCC_D_OPTS_H
+
+/* The values of -ftypeinfo=.  This file is included by options.h, so that
+   they can be named in lang.opt.  */
+
+enum typeinfo_emit
+{
+  typeinfo_emit_all,		/* Whenever the front-end asks for it.  */
+  typeinfo_emit_minimal		/* Only when referenced by generated code.  */
+};
+
+#endif
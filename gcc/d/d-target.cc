@@ -160,7 +160,7 @@ Target::_init (void)
   Target::ptrsize = (POINTER_SIZE / BITS_PER_UNIT);
   Target::c_longsize = int_size_in_bytes (long_integer_type_node);
 
-  Target::classinfosize = 19 * Target::ptrsize;
+  Target::classinfosize = 21 * Target::ptrsize;
 
   /* Initialize all compile-time properties for floating point types.
      Should ensure that our real_t type is able to represent real_value.  */
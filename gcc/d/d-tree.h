@@ -34,6 +34,9 @@ class Expression;
 class ClassReferenceExp;
 class Module;
 class Statement;
+class ForStatement;
+class IndexExp;
+class SliceExp;
 class Type;
 class TypeFunction;
 class Parameter;
@@ -43,6 +46,7 @@ struct Loc;
 
 template <typename TYPE> struct Array;
 typedef Array<Expression *> Expressions;
+typedef Array<class Module *> Modules;
 
 /* Usage of TREE_LANG_FLAG_?:
    0: METHOD_CALL_EXPR
@@ -216,6 +220,21 @@ struct GTY(()) lang_identifier
 #define IDENTIFIER_DSYMBOL(NODE) \
   (IDENTIFIER_LANG_SPECIFIC (NODE)->dsymbol)
 
+/* The block capacity cached for appending to a local array variable.  */
+
+struct GTY(()) d_append_cache
+{
+  /* The variable being appended to.  */
+  VarDeclaration * GTY((skip)) var;
+
+  /* Pointer to the used length of the block, or null if not known.  */
+  tree used;
+
+  /* The start of the array data, and the end of its capacity.  */
+  tree start;
+  tree capend;
+};
+
 /* Global state pertinent to the current function.  */
 
 struct GTY(()) language_function
@@ -236,6 +255,12 @@ struct GTY(()) language_function
 
   /* Table of all used or defined labels in the function.  */
   hash_map<Statement *, d_label_entry> *labels;
+
+  /* What is known about the array indexes in the function.  */
+  struct d_bounds_info * GTY((skip)) bounds;
+
+  /* Capacity caches for arrays appended to in the function.  */
+  vec<d_append_cache, va_gc> *append_caches;
 };
 
 /* The D front end types have not been integrated into the GCC garbage
@@ -455,6 +480,20 @@ enum libcall_fn
   LIBCALL_LAST,
 };
 
+/* In arrayops.cc.  */
+extern bool build_vector_arrayop (FuncDeclaration *);
+
+/* In bounds.cc.  */
+extern bool index_bounds_check_p (IndexExp *);
+extern bool slice_upper_check_p (SliceExp *);
+extern bool slice_lower_check_p (SliceExp *);
+extern size_t push_loop_bounds (ForStatement *);
+extern void pop_loop_bounds (size_t);
+extern void start_bounds_checks (Statement *);
+extern void record_bounds_checks (Statement *);
+extern void forget_bounds_checks (void);
+extern void finish_bounds_checks (void);
+
 /* In d-attribs.c.  */
 extern tree insert_type_attribute (tree, const char *, tree = NULL_TREE);
 extern tree insert_decl_attribute (tree, const char *, tree = NULL_TREE);
@@ -494,6 +533,7 @@ extern tree build_delegate_cst (tree, tree, Type *);
 extern tree build_method_call (tree, tree, Type *);
 extern void extract_from_method_call (tree, tree &, tree &);
 extern tree build_vindex_ref (tree, tree, size_t);
+extern tree build_class_instanceof (tree, ClassDeclaration *);
 extern tree d_save_expr (tree);
 extern tree stabilize_expr (tree *);
 extern tree build_target_expr (tree);
@@ -504,8 +544,9 @@ extern tree d_mark_read (tree);
 extern bool identity_compare_p (StructDeclaration *);
 extern tree build_struct_comparison (tree_code, StructDeclaration *,
 				     tree, tree);
-extern tree build_array_struct_comparison (tree_code, StructDeclaration *,
-					   tree, tree, tree);
+extern bool elem_comparison_p (Type *);
+extern tree build_array_elem_comparison (tree_code, Type *,
+					 tree, tree, tree);
 extern tree build_struct_literal (tree, vec<constructor_elt, va_gc> *);
 extern tree build_class_instance (ClassReferenceExp *);
 extern tree component_ref (tree, tree);
@@ -583,6 +624,10 @@ extern tree build_local_temp (tree);
 extern tree get_decl_tree (Declaration *);
 extern void d_finish_decl (tree);
 extern tree make_thunk (FuncDeclaration *, int);
+extern void record_inline_import (FuncDeclaration *);
+extern void build_inline_imports (void);
+extern void load_template_owners (const char *, Modules &);
+extern void save_template_owners (const char *);
 extern tree start_function (FuncDeclaration *);
 extern void finish_function (tree);
 extern void mark_needed (tree);
@@ -602,6 +647,7 @@ extern void d_comdat_linkage (tree);
 extern tree build_expr (Expression *, bool = false);
 extern tree build_expr_dtor (Expression *);
 extern tree build_return_dtor (Expression *, Type *, TypeFunction *);
+extern tree declare_append_caches (tree, tree);
 
 /* In imports.cc.  */
 extern tree build_import_decl (Dsymbol *);
@@ -626,6 +672,7 @@ extern tree get_typeinfo_decl (TypeInfoDeclaration *);
 extern tree get_classinfo_decl (ClassDeclaration *);
 extern tree build_typeinfo (Type *);
 extern void create_typeinfo (Type *, Module *);
+extern void dump_typeinfo_stats (void);
 extern void create_tinfo_types (Module *);
 extern void layout_cpp_typeinfo (ClassDeclaration *);
 extern tree get_cpp_typeinfo_decl (ClassDeclaration *);
@@ -109,6 +109,261 @@ gcc_attribute_p (Dsymbol *decl)
   return false;
 }
 
+/* With -ftemplate-owners=, the template instances named in the ownership
+   manifest and the module whose object file emits each one, the modules
+   having code generated in this compilation, and the claimant recorded as
+   the owner of instances not yet in the manifest.  */
+static hash_map<nofree_string_hash, const char *> *template_owners;
+static hash_set<nofree_string_hash> *template_modules;
+static const char *template_claimant;
+
+/* Instances emitted by this compilation, those of them that were claimed by
+   it, and the decision already made for each TemplateInstance.  */
+static hash_set<nofree_string_hash> *template_emitted;
+static vec<const char *> template_claims;
+static hash_map<TemplateInstance *, bool> *template_decisions;
+
+/* Lock the open manifest FD for reading or writing, waiting for any other
+   compilation holding the lock.  */
+
+static void
+lock_template_owners (int fd, short type)
+{
+#ifdef F_SETLKW
+  struct flock fl;
+  memset (&fl, 0, sizeof (fl));
+  fl.l_type = type;
+  fl.l_whence = SEEK_SET;
+
+  while (fcntl (fd, F_SETLKW, &fl) == -1 && errno == EINTR)
+    continue;
+#endif
+}
+
+/* Read the whole of the manifest FD, returning a nul terminated buffer.  */
+
+static char *
+read_template_owners (int fd)
+{
+  struct stat st;
+  size_t size = (fstat (fd, &st) == 0) ? st.st_size : 0;
+  char *buf = XNEWVEC (char, size + 1);
+  size_t len = 0;
+
+  lseek (fd, 0, SEEK_SET);
+  while (len < size)
+    {
+      ssize_t n = read (fd, buf + len, size - len);
+      if (n <= 0)
+	break;
+      len += n;
+    }
+
+  buf[len] = '\0';
+  return buf;
+}
+
+/* Split the next line of the manifest at *P into the mangled name of an
+   instance and the name of its owning module, advancing *P past it.
+   Blank lines and lines starting with `#' are skipped.  Returns false at
+   the end of the manifest.  */
+
+static bool
+next_template_owner (char **p, char **mangle, char **module)
+{
+  while (**p != '\0')
+    {
+      char *line = *p;
+      char *end = strchr (line, '\n');
+
+      if (end)
+	{
+	  *end = '\0';
+	  *p = end + 1;
+	}
+      else
+	*p = line + strlen (line);
+
+      if (*line == '#')
+	continue;
+
+      char *sep = strchr (line, ' ');
+      if (sep == NULL || sep == line || sep[1] == '\0')
+	continue;
+
+      *sep = '\0';
+      *mangle = line;
+      *module = sep + 1;
+      return true;
+    }
+
+  return false;
+}
+
+/* Read the template ownership manifest FILENAME before code generation of
+   MODULES, the first of which becomes the owner of any instance that is
+   emitted here and not yet claimed by another module.  */
+
+void
+load_template_owners (const char *filename, Modules &modules)
+{
+  template_owners = new hash_map<nofree_string_hash, const char *>;
+  template_modules = new hash_set<nofree_string_hash>;
+  template_emitted = new hash_set<nofree_string_hash>;
+  template_decisions = new hash_map<TemplateInstance *, bool>;
+
+  for (size_t i = 0; i < modules.dim; i++)
+    template_modules->add (modules[i]->toPrettyChars ());
+
+  template_claimant = modules.dim ? modules[0]->toPrettyChars () : NULL;
+
+  int fd = open (filename, O_RDONLY);
+  if (fd == -1)
+    {
+      /* The first compilation to use the manifest creates it.  */
+      if (errno != ENOENT)
+	error ("cannot read template owners file %qs: %m", filename);
+      return;
+    }
+
+  lock_template_owners (fd, F_RDLCK);
+  char *p = read_template_owners (fd);
+  close (fd);
+
+  char *mangle, *module;
+  while (next_template_owner (&p, &mangle, &module))
+    {
+      /* The first claim on an instance wins.  */
+      bool existed;
+      const char *&owner = template_owners->get_or_insert (mangle, &existed);
+      if (!existed)
+	owner = module;
+    }
+}
+
+/* Return true if code for the template instance TI is generated in this
+   compilation.  With -ftemplate-owners=, an instance that the front-end
+   would emit here is left external if another module owns it.  */
+
+static bool
+template_codegen_p (TemplateInstance *ti)
+{
+  if (!ti->needsCodegen ())
+    return false;
+
+  /* Instances local to a function can only be emitted along with it.  */
+  if (!template_owners || ti->enclosing || ti->isTemplateMixin ())
+    return true;
+
+  if (bool *decided = template_decisions->get (ti))
+    return *decided;
+
+  const char *mangle = mangle_decl (ti);
+  const char **owner = template_owners->get (mangle);
+  bool emit;
+
+  if (owner == NULL)
+    {
+      template_owners->put (mangle, template_claimant);
+      template_claims.safe_push (mangle);
+      emit = true;
+    }
+  else
+    emit = template_modules->contains (*owner);
+
+  if (emit)
+    template_emitted->add (mangle);
+
+  template_decisions->put (ti, emit);
+  return emit;
+}
+
+/* Give DECL, a symbol of the template instance TI, the linkage of a template
+   instance.  With -ftemplate-owners=, the owner's copy of an instance is the
+   one every other object links against, so it is kept even when nothing in
+   this compilation refers to it, and stays public on targets without
+   one-only support.  Other objects refer to it as a plain external, so that
+   its functions can still be compiled for inlining.  */
+
+static void
+template_instance_linkage (tree decl, TemplateInstance *ti)
+{
+  if (template_owners && ti && !ti->enclosing && !ti->isTemplateMixin ()
+      && TREE_PUBLIC (decl))
+    {
+      if (DECL_EXTERNAL (decl) || !supports_one_only ())
+	return;
+
+      d_comdat_linkage (decl);
+      mark_needed (decl);
+      return;
+    }
+
+  d_comdat_linkage (decl);
+}
+
+/* Write back the template ownership manifest FILENAME after code generation,
+   adding the instances claimed by this compilation.  Instances owned by the
+   modules compiled here that are no longer emitted by them are removed, so
+   that the next module to instantiate them claims them instead.  The
+   manifest is re-read under lock, as other compilations may have changed it
+   since it was loaded; if they claimed the same instance, it is emitted by
+   both as a COMDAT, and the first claim is kept.  */
+
+void
+save_template_owners (const char *filename)
+{
+  if (!template_owners)
+    return;
+
+  int fd = open (filename, O_RDWR | O_CREAT, 0666);
+  if (fd == -1)
+    {
+      error ("cannot write template owners file %qs: %m", filename);
+      return;
+    }
+
+  lock_template_owners (fd, F_WRLCK);
+  char *contents = read_template_owners (fd);
+  char *p = contents;
+
+  hash_set<nofree_string_hash> seen;
+  OutBuffer buf;
+  char *mangle, *module;
+
+  while (next_template_owner (&p, &mangle, &module))
+    {
+      if (seen.contains (mangle))
+	continue;
+
+      if (template_modules->contains (module)
+	  && !template_emitted->contains (mangle))
+	continue;
+
+      seen.add (mangle);
+      buf.printf ("%s %s\n", mangle, module);
+    }
+
+  for (size_t i = 0; i < template_claims.length (); i++)
+    {
+      if (seen.add (template_claims[i]))
+	continue;
+
+      buf.printf ("%s %s\n", template_claims[i], template_claimant);
+    }
+
+  if (ftruncate (fd, 0) != 0 || lseek (fd, 0, SEEK_SET) != 0
+      || write (fd, buf.data, buf.offset) != (ssize_t) buf.offset)
+    error ("cannot write template owners file %qs: %m", filename);
+
+  close (fd);
+  XDELETEVEC (contents);
+
+  template_claims.release ();
+  delete template_decisions;
+  template_decisions = NULL;
+}
+
 /* Implements the visitor interface to lower all Declaration AST classes
    emitted from the D Front-end to GCC trees.
    All visit methods accept one parameter D, which holds the frontend AST
@@ -257,7 +512,7 @@ public:
     if (isError (d)|| !d->members)
       return;
 
-    if (!d->needsCodegen ())
+    if (!template_codegen_p (d))
       return;
 
     for (size_t i = 0; i < d->members->dim; i++)
@@ -313,8 +568,8 @@ public:
     d->sinit = aggregate_initializer_decl (d);
     DECL_INITIAL (d->sinit) = layout_struct_initializer (d);
 
-    if (d->isInstantiated ())
-      d_comdat_linkage (d->sinit);
+    if (TemplateInstance *ti = d->isInstantiated ())
+      template_instance_linkage (d->sinit, ti);
 
     d_finish_decl (d->sinit);
 
@@ -366,13 +621,13 @@ public:
 
     /* Generate static initialiser.  */
     DECL_INITIAL (d->sinit) = layout_class_initializer (d);
-    d_comdat_linkage (d->sinit);
+    template_instance_linkage (d->sinit, d->isInstantiated ());
     d_finish_decl (d->sinit);
 
     /* Put out the TypeInfo.  */
     create_typeinfo (d->type, NULL);
     DECL_INITIAL (d->csym) = layout_classinfo (d);
-    d_comdat_linkage (d->csym);
+    template_instance_linkage (d->csym, d->isInstantiated ());
     d_finish_decl (d->csym);
 
     /* Put out the vtbl[].  */
@@ -435,7 +690,7 @@ public:
 
     DECL_INITIAL (d->vtblsym)
       = build_constructor (TREE_TYPE (d->vtblsym), elms);
-    d_comdat_linkage (d->vtblsym);
+    template_instance_linkage (d->vtblsym, d->isInstantiated ());
     d_finish_decl (d->vtblsym);
 
     /* Add this decl to the current binding level.  */
@@ -473,7 +728,7 @@ public:
     d->type->vtinfo->accept (this);
 
     DECL_INITIAL (d->csym) = layout_classinfo (d);
-    d_comdat_linkage (d->csym);
+    template_instance_linkage (d->csym, d->isInstantiated ());
     d_finish_decl (d->csym);
 
     /* Add this decl to the current binding level.  */
@@ -509,8 +764,8 @@ public:
 	d->sinit = enum_initializer_decl (d);
 	DECL_INITIAL (d->sinit) = build_expr (tc->sym->defaultval, true);
 
-	if (d->isInstantiated ())
-	  d_comdat_linkage (d->sinit);
+	if (TemplateInstance *ti = d->isInstantiated ())
+	  template_instance_linkage (d->sinit, ti);
 
 	d_finish_decl (d->sinit);
 
@@ -644,6 +899,11 @@ public:
 
   void visit (TypeInfoDeclaration *d)
   {
+    if (d->semanticRun >= PASSobj)
+      return;
+
+    d->semanticRun = PASSobj;
+
     if (speculative_type_p (d->tinfo))
       return;
 
@@ -855,7 +1115,8 @@ public:
 	  }
       }
 
-    build_function_body (d);
+    if (!d->isArrayOp || !build_vector_arrayop (d))
+      build_function_body (d);
 
     if (d->v_argptr)
       {
@@ -889,7 +1150,7 @@ build_decl_tree (Dsymbol *d)
   location_t saved_location = input_location;
 
   /* Set input location, empty DECL_SOURCE_FILE can crash debug generator.  */
-  if (d->loc.filename)
+  if (d->loc.filename ())
     input_location = get_linemap (d->loc);
   else
     input_location = get_linemap (Loc ("<no_file>", 1, 0));
@@ -1188,7 +1449,7 @@ get_symbol_decl (Declaration *decl)
       TemplateInstance *ti = decl->isInstantiated ();
       if (ti)
 	{
-	  if (!DECL_EXTERNAL (decl->csym) && ti->needsCodegen ())
+	  if (!DECL_EXTERNAL (decl->csym) && template_codegen_p (ti))
 	    {
 	      /* Warn about templates instantiated in this compilation.  */
 	      if (ti == decl->parent)
@@ -1202,7 +1463,7 @@ get_symbol_decl (Declaration *decl)
 	  else
 	    DECL_EXTERNAL (decl->csym) = 1;
 
-	  d_comdat_linkage (decl->csym);
+	  template_instance_linkage (decl->csym, ti);
 
 	  /* Normally the backend only emits COMDAT things when they are needed.
 	     If this decl is meant to be externally visible, then make sure that
@@ -1712,6 +1973,158 @@ make_thunk (FuncDeclaration *decl, int offset)
   return thunk;
 }
 
+/* Imported functions that are called directly from code being compiled, in
+   the order they were first seen, and how many calls were made to each.  */
+static vec<FuncDeclaration *> inline_imports;
+static hash_map<FuncDeclaration *, unsigned> *inline_import_calls;
+
+/* Return true if FD is a function defined in a module not being compiled,
+   or with -ftemplate-owners=, a member of a template instance owned by
+   another module, whose body is not otherwise going to be generated.  */
+
+static bool
+imported_function_p (FuncDeclaration *fd)
+{
+  if (TemplateInstance *ti = fd->isInstantiated ())
+    {
+      return template_owners && !ti->enclosing && !ti->isTemplateMixin ()
+	&& !template_codegen_p (ti);
+    }
+
+  return fd->getModule () && !fd->getModule ()->isRoot ();
+}
+
+/* Record a direct call to FD.  With -finline-imports, imported functions that
+   are called from code being compiled are candidates for having their bodies
+   compiled, so that they can be inlined across modules.  */
+
+void
+record_inline_import (FuncDeclaration *fd)
+{
+  /* Without -ftemplate-owners=, every object had the bodies of the instances
+     it uses, so keep making them available for inlining when optimizing.  */
+  bool instance_p = template_owners && optimize && fd->isInstantiated ();
+
+  if (!instance_p && (!flag_inline_imports || !global.params.useInline))
+    return;
+
+  if (!imported_function_p (fd))
+    return;
+
+  if (!inline_import_calls)
+    inline_import_calls = new hash_map<FuncDeclaration *, unsigned>;
+
+  bool existed;
+  unsigned &calls = inline_import_calls->get_or_insert (fd, &existed);
+
+  if (!existed)
+    {
+      calls = 0;
+      inline_imports.safe_push (fd);
+    }
+
+  calls++;
+}
+
+/* Return the reason for not compiling the body of the imported function FD,
+   or NULL if it is small enough to be worth inlining.  The inlining cost, if
+   it was computed, is stored in COST.  */
+
+static const char *
+skip_inline_import (FuncDeclaration *fd, int *cost)
+{
+  *cost = -1;
+
+  if (!fd->fbody)
+    return "no body";
+
+  if (fd->semanticRun >= PASSobj)
+    return "already compiled";
+
+  if (fd->inlining == PINLINEnever)
+    return "pragma(inline, false)";
+
+  if (gcc_attribute_p (fd) || fd->isImportedSymbol ())
+    return "not inlinable";
+
+  if (fd->type->ty != Tfunction)
+    return "semantic errors";
+
+  if (((TypeFunction *) fd->type)->varargs == 1)
+    return "variadic";
+
+  if (fd->isNested ())
+    return "nested function";
+
+  /* Analysing the body of an imported function may raise errors that will be
+     reported when its own module is compiled, don't report them here.  */
+  if (fd->semanticRun < PASSsemantic3)
+    {
+      unsigned errors = global.startGagging ();
+      fd->functionSemantic3 ();
+      Module::runDeferredSemantic3 ();
+
+      if (global.endGagging (errors))
+	return "semantic errors";
+    }
+
+  if (fd->semantic3Errors || fd->semanticRun < PASSsemantic3done)
+    return "semantic errors";
+
+  if (fd->hasNestedFrameRefs ())
+    return "nested frame";
+
+  if (fd->inlining == PINLINEalways)
+    return NULL;
+
+  /* Use the same measure of size as the front-end does when deciding whether
+     to keep a function body in a generated interface file.  */
+  *cost = inlineCostFunction (fd, fd->needThis (), true);
+  if (tooCostly (*cost))
+    return "too costly";
+
+  return NULL;
+}
+
+/* Compile the bodies of all imported functions recorded by record_inline_import
+   that are small enough to be inlined.  The bodies are emitted as external
+   definitions, so no code is generated for them in this module.  Compiling
+   a body may record further calls, which are also considered.  */
+
+void
+build_inline_imports (void)
+{
+  for (size_t i = 0; i < inline_imports.length (); i++)
+    {
+      FuncDeclaration *fd = inline_imports[i];
+      unsigned calls = *inline_import_calls->get (fd);
+      int cost;
+
+      const char *reason = skip_inline_import (fd, &cost);
+
+      if (reason == NULL)
+	build_decl_tree (fd);
+
+      if (flag_dump_inline_imports)
+	{
+	  fprintf (global.stdmsg, "%-9s %s (calls %u",
+		   reason ? "noinline" : "inline", fd->toPrettyChars (), calls);
+	  if (cost >= 0)
+	    fprintf (global.stdmsg, ", cost %d", cost);
+	  if (reason)
+	    fprintf (global.stdmsg, ", %s", reason);
+	  fprintf (global.stdmsg, ")\n");
+	}
+
+      if (global.errors)
+	break;
+    }
+
+  inline_imports.release ();
+  delete inline_import_calls;
+  inline_import_calls = NULL;
+}
+
 /* Create the FUNCTION_DECL for a function definition.
    This function creates a binding context for the function body
    as well as setting up the FUNCTION_DECL in current_function_decl.
@@ -1724,8 +2137,7 @@ start_function (FuncDeclaration *fd)
 
   /* If we are generating the function, but it's really extern.
      Such as external inlinable functions or thunk aliases.  */
-  if (!fd->isInstantiated () && fd->getModule ()
-      && !fd->getModule ()->isRoot ())
+  if (imported_function_p (fd))
     {
       TREE_STATIC (fndecl) = 0;
       DECL_EXTERNAL (fndecl) = 1;
@@ -1764,7 +2176,7 @@ start_function (FuncDeclaration *fd)
   allocate_struct_function (fndecl, false);
 
   /* Store the end of the function.  */
-  if (fd->endloc.filename)
+  if (fd->endloc.filename ())
     cfun->function_end_locus = get_linemap (fd->endloc);
   else
     cfun->function_end_locus = DECL_SOURCE_LOCATION (fndecl);
@@ -1802,7 +2214,7 @@ finish_function (tree old_context)
 
   /* Tie off the statement tree for this function.  */
   tree block = pop_binding_level ();
-  tree body = pop_stmt_list ();
+  tree body = declare_append_caches (block, pop_stmt_list ());
   tree bind = build3 (BIND_EXPR, void_type_node,
 		      BLOCK_VARS (block), body, block);
 
@@ -1834,6 +2246,7 @@ finish_function (tree old_context)
     }
 
   /* We're leaving the context of this function, so free it.  */
+  finish_bounds_checks ();
   ggc_free (cfun->language);
   cfun->language = NULL;
   set_cfun (NULL);
@@ -176,6 +176,30 @@ void dmd_aaRehash(AA** paa)
 }
 
 
+/********************************************
+ * Call fp(param, key, value) for each entry in the array,
+ * stopping early if fp returns nonzero.
+ * Returns:
+ *      the last value returned by fp, or 0 if no entries
+ */
+
+int dmd_aaApply(AA* aa, int (*fp)(void *, Key, Value), void *param)
+{
+    if (!aa)
+        return 0;
+
+    for (size_t k = 0; k < aa->b_length; k++)
+    {
+        for (aaA *e = aa->b[k]; e; e = e->next)
+        {
+            if (int result = (*fp)(param, e->key, e->value))
+                return result;
+        }
+    }
+    return 0;
+}
+
+
 #if UNITTEST
 
 void unittest_aa()
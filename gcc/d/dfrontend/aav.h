@@ -16,4 +16,5 @@ size_t dmd_aaLen(AA* aa);
 Value* dmd_aaGet(AA** aa, Key key);
 Value dmd_aaGetRvalue(AA* aa, Key key);
 void dmd_aaRehash(AA** paa);
+int dmd_aaApply(AA* aa, int (*fp)(void *, Key, Value), void *param);
 
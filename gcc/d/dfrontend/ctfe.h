@@ -35,6 +35,43 @@ struct CtfeStatus
     static int numAssignments; // total number of assignments executed
 };
 
+/**
+  Region allocator for values created while interpreting. Everything
+  allocated between the outermost enter() and leave() is released at
+  once by leave(), so only the result of ctfeInterpret may outlive it,
+  and that is copied out to permanent memory with ctfeCopyOut().
+  Outside of an evaluation, alloc() returns ordinary heap memory.
+
+  The element storage of Expressions arrays is not put in the arena, even
+  for arrays that the interpreter creates: Array grows it with xrealloc,
+  which cannot be applied to arena memory, and an array that reaches the
+  result can still be grown by constfold and semantic after the arena is
+  released.
+ */
+struct CtfeArena
+{
+    static void *alloc(size_t size);
+    static bool contains(const void *p);
+    static void enter();
+    static void leave();
+};
+
+extern CtfeArena ctfeArena;
+
+inline void *operator new(size_t size, CtfeArena &)
+{
+    return CtfeArena::alloc(size);
+}
+
+inline void operator delete(void *, CtfeArena &)
+{
+}
+
+/// Shallow copy of e, allocated in the CTFE arena
+Expression *ctfeCopy(Expression *e);
+/// Deep copy of the arena-owned parts of e to permanent memory
+Expression *ctfeCopyOut(Expression *e);
+
 /**
   A reference to a class, or an interface. We need this when we
   point to a base class (we must record what the type is).
@@ -138,7 +138,7 @@ void ThrownExceptionExp::generateUncaughtError()
      * in the case where the ThrowStatement is generated internally
      * (eg, in ScopeStatement)
      */
-    if (loc.filename && !loc.equals(thrown->loc))
+    if (loc.filename() && !loc.equals(thrown->loc))
         errorSupplemental(loc, "thrown from here");
 }
 
@@ -188,6 +188,313 @@ Expression *UnionExp::copy()
     return e->copy();
 }
 
+Expression *UnionExp::ctfeCopy()
+{
+    Expression *e = exp();
+    assert(e->size <= sizeof(u));
+    if (e->op == TOKcantexp)    return CTFEExp::cantexp;
+    if (e->op == TOKvoidexp)    return CTFEExp::voidexp;
+    if (e->op == TOKbreak)      return CTFEExp::breakexp;
+    if (e->op == TOKcontinue)   return CTFEExp::continueexp;
+    if (e->op == TOKgoto)       return CTFEExp::gotoexp;
+    return ::ctfeCopy(e);
+}
+
+/************** CtfeArena ********************************************/
+
+CtfeArena ctfeArena;
+
+/* Memory handed out by the arena, sorted by address so that contains()
+ * can do a binary search.
+ */
+struct CtfeChunk
+{
+    char *base;
+    size_t size;
+};
+
+static Array<CtfeChunk> ctfeChunks;
+static char *ctfeArenaPtr = NULL;       // next free byte in the current chunk
+static char *ctfeArenaEnd = NULL;       // end of the current chunk
+static int ctfeArenaDepth = 0;          // nesting of ctfeInterpret
+
+#define CTFE_CHUNK_SIZE     (1024 * 1024 - 64)
+
+static char *newCtfeChunk(size_t size)
+{
+    CtfeChunk c;
+    c.base = (char *)mem.xmalloc(size);
+    c.size = size;
+
+    size_t lo = 0;
+    size_t hi = ctfeChunks.dim;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (ctfeChunks[mid].base < c.base)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    ctfeChunks.insert(lo, c);
+    return c.base;
+}
+
+void *CtfeArena::alloc(size_t size)
+{
+    if (!ctfeArenaDepth)
+        return mem.xmalloc(size);
+
+    size = (size + 15) & ~(size_t)15;
+    if (size > (size_t)(ctfeArenaEnd - ctfeArenaPtr))
+    {
+        // Big blocks get a chunk to themselves, so the rest of the
+        // current chunk is not wasted.
+        if (size > CTFE_CHUNK_SIZE / 4)
+            return newCtfeChunk(size);
+        ctfeArenaPtr = newCtfeChunk(CTFE_CHUNK_SIZE);
+        ctfeArenaEnd = ctfeArenaPtr + CTFE_CHUNK_SIZE;
+    }
+    void *p = ctfeArenaPtr;
+    ctfeArenaPtr += size;
+    return p;
+}
+
+bool CtfeArena::contains(const void *p)
+{
+    size_t lo = 0;
+    size_t hi = ctfeChunks.dim;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (ctfeChunks[mid].base <= (const char *)p)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return false;
+    CtfeChunk &c = ctfeChunks[lo - 1];
+    return (const char *)p < c.base + c.size;
+}
+
+void CtfeArena::enter()
+{
+    ctfeArenaDepth++;
+}
+
+void CtfeArena::leave()
+{
+    assert(ctfeArenaDepth > 0);
+    if (--ctfeArenaDepth)
+        return;
+
+    // Release everything, but hang on to one chunk for the next evaluation.
+    char *keep = NULL;
+    for (size_t i = 0; i < ctfeChunks.dim; i++)
+    {
+        CtfeChunk &c = ctfeChunks[i];
+        if (!keep && c.size == CTFE_CHUNK_SIZE)
+            keep = c.base;
+        else
+            mem.xfree(c.base);
+    }
+    ctfeChunks.setDim(0);
+    ctfeArenaPtr = ctfeArenaEnd = NULL;
+    if (keep)
+    {
+        CtfeChunk c;
+        c.base = keep;
+        c.size = CTFE_CHUNK_SIZE;
+        ctfeChunks.push(c);
+        ctfeArenaPtr = keep;
+        ctfeArenaEnd = keep + CTFE_CHUNK_SIZE;
+    }
+}
+
+Expression *ctfeCopy(Expression *e)
+{
+    assert(e->size);
+    void *p = CtfeArena::alloc(e->size);
+    return (Expression *)memcpy(p, (void *)e, e->size);
+}
+
+/* Walks everything reachable from a CTFE result, replacing nodes and
+ * string data that live in the arena with copies on the heap.
+ * Nodes already on the heap are fixed up in place.
+ */
+class CtfeCopyOut : public Visitor
+{
+public:
+    // Open addressed table of nodes already done, and what they became.
+    Expression **keys;
+    Expression **vals;
+    size_t cap;
+    size_t count;
+
+    CtfeCopyOut()
+    {
+        cap = 64;
+        count = 0;
+        keys = (Expression **)CtfeArena::alloc(cap * sizeof(Expression *));
+        vals = (Expression **)CtfeArena::alloc(cap * sizeof(Expression *));
+        memset(keys, 0, cap * sizeof(Expression *));
+    }
+
+    size_t slot(Expression **tab, size_t n, Expression *e)
+    {
+        size_t i = ((size_t)e >> 4) & (n - 1);
+        while (tab[i] && tab[i] != e)
+            i = (i + 1) & (n - 1);
+        return i;
+    }
+
+    void record(Expression *e, Expression *r)
+    {
+        if (2 * (count + 1) > cap)
+        {
+            size_t ncap = cap * 2;
+            Expression **nkeys = (Expression **)CtfeArena::alloc(ncap * sizeof(Expression *));
+            Expression **nvals = (Expression **)CtfeArena::alloc(ncap * sizeof(Expression *));
+            memset(nkeys, 0, ncap * sizeof(Expression *));
+            for (size_t i = 0; i < cap; i++)
+            {
+                if (!keys[i])
+                    continue;
+                size_t j = slot(nkeys, ncap, keys[i]);
+                nkeys[j] = keys[i];
+                nvals[j] = vals[i];
+            }
+            keys = nkeys;
+            vals = nvals;
+            cap = ncap;
+        }
+        size_t i = slot(keys, cap, e);
+        keys[i] = e;
+        vals[i] = r;
+        count++;
+    }
+
+    Expression *lookup(Expression *e)
+    {
+        size_t i = slot(keys, cap, e);
+        return keys[i] ? vals[i] : NULL;
+    }
+
+    Expression *copyOut(Expression *e)
+    {
+        if (!e)
+            return NULL;
+        if (Expression *r = lookup(e))
+            return r;
+        Expression *r = CtfeArena::contains(e) ? e->copy() : e;
+        record(e, r);
+        r->accept(this);
+        return r;
+    }
+
+    Expressions *copyOut(Expressions *elems)
+    {
+        if (!elems)
+            return NULL;
+        Expressions *r = elems;
+        for (size_t i = 0; i < elems->dim; i++)
+        {
+            Expression *m = copyOut((*elems)[i]);
+            if (m == (*elems)[i])
+                continue;
+            // The array may be shared with a node that is not ours to change.
+            if (r == elems)
+                r = elems->copy();
+            (*r)[i] = m;
+        }
+        return r;
+    }
+
+    void visit(Expression *)
+    {
+    }
+
+    void visit(UnaExp *e)
+    {
+        e->e1 = copyOut(e->e1);
+    }
+
+    void visit(BinExp *e)
+    {
+        e->e1 = copyOut(e->e1);
+        e->e2 = copyOut(e->e2);
+    }
+
+    void visit(CondExp *e)
+    {
+        e->econd = copyOut(e->econd);
+        visit((BinExp *)e);
+    }
+
+    void visit(SliceExp *e)
+    {
+        e->lwr = copyOut(e->lwr);
+        e->upr = copyOut(e->upr);
+        visit((UnaExp *)e);
+    }
+
+    void visit(TupleExp *e)
+    {
+        e->e0 = copyOut(e->e0);
+        e->exps = copyOut(e->exps);
+    }
+
+    void visit(StringExp *e)
+    {
+        if (CtfeArena::contains(e->string))
+        {
+            size_t size = (e->len + 1) * e->sz;
+            e->string = memcpy(mem.xmalloc(size), e->string, size);
+        }
+    }
+
+    void visit(ArrayLiteralExp *e)
+    {
+        e->basis = copyOut(e->basis);
+        e->elements = copyOut(e->elements);
+    }
+
+    void visit(AssocArrayLiteralExp *e)
+    {
+        e->keys = copyOut(e->keys);
+        e->values = copyOut(e->values);
+    }
+
+    void visit(StructLiteralExp *e)
+    {
+        if (CtfeArena::contains(e->origin))
+        {
+            Expression *o = lookup(e->origin);
+            e->origin = o ? (StructLiteralExp *)o : e;
+        }
+        if (CtfeArena::contains(e->inlinecopy))
+            e->inlinecopy = NULL;
+        e->elements = copyOut(e->elements);
+    }
+
+    void visit(ClassReferenceExp *e)
+    {
+        e->value = (StructLiteralExp *)copyOut(e->value);
+    }
+
+    void visit(ThrownExceptionExp *e)
+    {
+        e->thrown = (ClassReferenceExp *)copyOut(e->thrown);
+    }
+};
+
+Expression *ctfeCopyOut(Expression *e)
+{
+    CtfeCopyOut v;
+    return v.copyOut(e);
+}
+
 /************** Aggregate literals (AA/string/array/struct) ******************/
 
 // Given expr, which evaluates to an array/AA/string literal,
@@ -240,7 +547,7 @@ Expressions *copyLiteralArray(Expressions *oldelems, Expression *basis = NULL)
         Expression *el = (*oldelems)[i];
         if (!el)
             el = basis;
-        (*newelems)[i] = copyLiteral(el).copy();
+        (*newelems)[i] = copyLiteral(el).ctfeCopy();
     }
     return newelems;
 }
@@ -253,8 +560,9 @@ UnionExp copyLiteral(Expression *e)
     if (e->op == TOKstring) // syntaxCopy doesn't make a copy for StringExp!
     {
         StringExp *se = (StringExp *)e;
-        utf8_t *s = (utf8_t *)mem.xcalloc(se->len + 1, se->sz);
+        utf8_t *s = (utf8_t *)CtfeArena::alloc((se->len + 1) * se->sz);
         memcpy(s, se->string, se->len * se->sz);
+        memset(s + se->len * se->sz, 0, se->sz);
         new(&ue) StringExp(se->loc, s, se->len);
         StringExp *se2 = (StringExp *)ue.exp();
         se2->committed = se->committed;
@@ -267,7 +575,7 @@ UnionExp copyLiteral(Expression *e)
     if (e->op == TOKarrayliteral)
     {
         ArrayLiteralExp *ale = (ArrayLiteralExp *)e;
-        Expression *basis = ale->basis ? copyLiteral(ale->basis).copy() : NULL;
+        Expression *basis = ale->basis ? copyLiteral(ale->basis).ctfeCopy() : NULL;
         Expressions *elements = copyLiteralArray(ale->elements, ale->basis);
 
         new(&ue) ArrayLiteralExp(e->loc, elements);
@@ -304,7 +612,7 @@ UnionExp copyLiteral(Expression *e)
 
             // If it is a void assignment, use the default initializer
             if (!m)
-                m = voidInitLiteral(v->type, v).copy();
+                m = voidInitLiteral(v->type, v).ctfeCopy();
 
             if (v->type->ty == Tarray || v->type->ty == Taarray)
             {
@@ -313,7 +621,7 @@ UnionExp copyLiteral(Expression *e)
             else
             {
                 // Buzilla 15681: Copy the source element always.
-                m = copyLiteral(m).copy();
+                m = copyLiteral(m).ctfeCopy();
 
                 // Block assignment from inside struct literals
                 if (v->type->ty != m->type->ty && v->type->ty == Tsarray)
@@ -417,7 +725,7 @@ Expression *paintTypeOntoLiteral(Type *type, Expression *lit)
 {
     if (lit->type->equals(type))
         return lit;
-    return paintTypeOntoLiteralCopy(type, lit).copy();
+    return paintTypeOntoLiteralCopy(type, lit).ctfeCopy();
 }
 
 UnionExp paintTypeOntoLiteralCopy(Type *type, Expression *lit)
@@ -451,13 +759,13 @@ UnionExp paintTypeOntoLiteralCopy(Type *type, Expression *lit)
     else if (lit->op == TOKarrayliteral)
     {
         new(&ue) SliceExp(lit->loc, lit,
-            new IntegerExp(Loc(), 0, Type::tsize_t), ArrayLength(Type::tsize_t, lit).copy());
+            new (ctfeArena) IntegerExp(Loc(), 0, Type::tsize_t), ArrayLength(Type::tsize_t, lit).ctfeCopy());
     }
     else if (lit->op == TOKstring)
     {
         // For strings, we need to introduce another level of indirection
         new(&ue) SliceExp(lit->loc, lit,
-            new IntegerExp(Loc(), 0, Type::tsize_t), ArrayLength(Type::tsize_t, lit).copy());
+            new (ctfeArena) IntegerExp(Loc(), 0, Type::tsize_t), ArrayLength(Type::tsize_t, lit).ctfeCopy());
     }
     else if (lit->op == TOKassocarrayliteral)
     {
@@ -488,7 +796,7 @@ Expression *resolveSlice(Expression *e)
     SliceExp *se = (SliceExp *)e;
     if (se->e1->op == TOKnull)
         return se->e1;
-    return Slice(e->type, se->e1, se->lwr, se->upr).copy();
+    return Slice(e->type, se->e1, se->lwr, se->upr).ctfeCopy();
 }
 
 /* Determine the array length, without interpreting it.
@@ -557,9 +865,9 @@ ArrayLiteralExp *createBlockDuplicatedArrayLiteral(Loc loc, Type *type,
     elements->setDim(dim);
     for (size_t i = 0; i < dim; i++)
     {
-        (*elements)[i] = mustCopy ? copyLiteral(elem).copy() : elem;
+        (*elements)[i] = mustCopy ? copyLiteral(elem).ctfeCopy() : elem;
     }
-    ArrayLiteralExp *ale = new ArrayLiteralExp(loc, elements);
+    ArrayLiteralExp *ale = new (ctfeArena) ArrayLiteralExp(loc, elements);
     ale->type = type;
     ale->ownedByCtfe = OWNEDctfe;
     return ale;
@@ -572,7 +880,8 @@ ArrayLiteralExp *createBlockDuplicatedArrayLiteral(Loc loc, Type *type,
 StringExp *createBlockDuplicatedStringLiteral(Loc loc, Type *type,
         unsigned value, size_t dim, unsigned char sz)
 {
-    utf8_t *s = (utf8_t *)mem.xcalloc(dim + 1, sz);
+    utf8_t *s = (utf8_t *)CtfeArena::alloc((dim + 1) * sz);
+    memset(s + dim * sz, 0, sz);
     for (size_t elemi = 0; elemi < dim; ++elemi)
     {
         switch (sz)
@@ -583,7 +892,7 @@ StringExp *createBlockDuplicatedStringLiteral(Loc loc, Type *type,
             default:    assert(0);
         }
     }
-    StringExp *se = new StringExp(loc, s, dim);
+    StringExp *se = new (ctfeArena) StringExp(loc, s, dim);
     se->type = type;
     se->sz = sz;
     se->committed = true;
@@ -845,7 +1154,7 @@ UnionExp pointerArithmetic(Loc loc, TOK op, Type *type,
     }
     else
     {
-        Expression *dollar = ArrayLength(Type::tsize_t, agg1).copy();
+        Expression *dollar = ArrayLength(Type::tsize_t, agg1).ctfeCopy();
         assert(!CTFEExp::isCantExp(dollar));
         indx = ofs1;
         len = dollar->toInteger();
@@ -885,9 +1194,9 @@ UnionExp pointerArithmetic(Loc loc, TOK op, Type *type,
         dinteger_t dim = ((TypeSArray *)eptr->type->toBasetype())->dim->toInteger();
 
         // Create a CTFE pointer &agg1[indx .. indx+dim]
-        SliceExp *se = new SliceExp(loc, agg1,
-            new IntegerExp(loc, indx,       Type::tsize_t),
-            new IntegerExp(loc, indx + dim, Type::tsize_t));
+        SliceExp *se = new (ctfeArena) SliceExp(loc, agg1,
+            new (ctfeArena) IntegerExp(loc, indx,       Type::tsize_t),
+            new (ctfeArena) IntegerExp(loc, indx + dim, Type::tsize_t));
         se->type = type->toBasetype()->nextOf();
         new(&ue) AddrExp(loc, se);
         ue.exp()->type = type;
@@ -895,8 +1204,8 @@ UnionExp pointerArithmetic(Loc loc, TOK op, Type *type,
     }
 
     // Create a CTFE pointer &agg1[indx]
-    IntegerExp *ofs = new IntegerExp(loc, indx, Type::tsize_t);
-    Expression *ie = new IndexExp(loc, agg1, ofs);
+    IntegerExp *ofs = new (ctfeArena) IntegerExp(loc, indx, Type::tsize_t);
+    Expression *ie = new (ctfeArena) IndexExp(loc, agg1, ofs);
     ie->type = type->toBasetype()->nextOf();    // Bugzilla 13992
     new(&ue) AddrExp(loc, ie);
     ue.exp()->type = type;
@@ -1432,6 +1741,29 @@ UnionExp ctfeCat(Type *type, Expression *e1, Expression *e2)
     Type *t1 = e1->type->toBasetype();
     Type *t2 = e2->type->toBasetype();
     UnionExp ue;
+    if (e1->op == TOKstring && e2->op == TOKstring &&
+        ((StringExp *)e1)->sz == ((StringExp *)e2)->sz)
+    {
+        // string ~ string => string, as for Cat() but in the CTFE arena
+        StringExp *es1 = (StringExp *)e1;
+        StringExp *es2 = (StringExp *)e2;
+        size_t len = es1->len + es2->len;
+        unsigned char sz = es1->sz;
+
+        void *s = CtfeArena::alloc((len + 1) * sz);
+        memcpy(s, es1->string, es1->len * sz);
+        memcpy((char *)s + es1->len * sz, es2->string, es2->len * sz);
+
+        // Add terminating 0
+        memset((char *)s + len * sz, 0, sz);
+
+        new(&ue) StringExp(loc, s, len);
+        StringExp *es = (StringExp *)ue.exp();
+        es->sz = sz;
+        es->committed = es1->committed | es2->committed;
+        es->type = type;
+        return ue;
+    }
     if (e2->op == TOKstring && e1->op == TOKarrayliteral &&
         t1->nextOf()->isintegral())
     {
@@ -1441,7 +1773,7 @@ UnionExp ctfeCat(Type *type, Expression *e1, Expression *e2)
         size_t len = es1->len + es2->elements->dim;
         unsigned char sz = es1->sz;
 
-        void *s = mem.xmalloc((len + 1) * sz);
+        void *s = CtfeArena::alloc((len + 1) * sz);
         memcpy((char *)s + sz * es2->elements->dim, es1->string, es1->len * sz);
         for (size_t i = 0; i < es2->elements->dim; i++)
         {
@@ -1475,7 +1807,7 @@ UnionExp ctfeCat(Type *type, Expression *e1, Expression *e2)
         size_t len = es1->len + es2->elements->dim;
         unsigned char sz = es1->sz;
 
-        void *s = mem.xmalloc((len + 1) * sz);
+        void *s = CtfeArena::alloc((len + 1) * sz);
         memcpy(s, es1->string, es1->len * sz);
         for (size_t i = 0; i < es2->elements->dim; i++)
         {
@@ -1516,14 +1848,14 @@ UnionExp ctfeCat(Type *type, Expression *e1, Expression *e2)
         t1->nextOf()->equals(t2->nextOf()))
     {
         //  [ e1 ] ~ null ----> [ e1 ].dup
-        ue = paintTypeOntoLiteralCopy(type, copyLiteral(e1).copy());
+        ue = paintTypeOntoLiteralCopy(type, copyLiteral(e1).ctfeCopy());
         return ue;
     }
     if (e1->op == TOKnull && e2->op == TOKarrayliteral &&
         t1->nextOf()->equals(t2->nextOf()))
     {
         //  null ~ [ e2 ] ----> [ e2 ].dup
-        ue = paintTypeOntoLiteralCopy(type, copyLiteral(e2).copy());
+        ue = paintTypeOntoLiteralCopy(type, copyLiteral(e2).ctfeCopy());
         return ue;
     }
     ue = Cat(type, e1, e2);
@@ -1566,7 +1898,7 @@ Expression *ctfeIndex(Loc loc, Type *type, Expression *e1, uinteger_t indx)
             error(loc, "string index %llu is out of bounds [0 .. %llu]", indx, (ulonglong)es1->len);
             return CTFEExp::cantexp;
         }
-        return new IntegerExp(loc, es1->charAt(indx), type);
+        return new (ctfeArena) IntegerExp(loc, es1->charAt(indx), type);
     }
     assert(e1->op == TOKarrayliteral);
     {
@@ -1593,7 +1925,7 @@ Expression *ctfeCast(Loc loc, Type *type, Type *to, Expression *e)
         if (originalClass->type->implicitConvTo(to->mutableOf()))
             return paintTypeOntoLiteral(to, e);
         else
-            return new NullExp(loc, to);
+            return new (ctfeArena) NullExp(loc, to);
     }
     // Allow TypeInfo type painting
     if (isTypeInfo_Class(e->type) && e->type->implicitConvTo(to))
@@ -1619,7 +1951,7 @@ Expression *ctfeCast(Loc loc, Type *type, Type *to, Expression *e)
     }
     else
     {
-        r = Cast(type, to, e).copy();
+        r = Cast(type, to, e).ctfeCopy();
     }
     if (CTFEExp::isCantExp(r))
         error(loc, "cannot cast %s to %s at compile time", e->toChars(), to->toChars());
@@ -1724,7 +2056,7 @@ Expression *modifyStructField(Type *type, StructLiteralExp *se, size_t offset, E
     /* Create new struct literal reflecting updated fieldi
     */
     Expressions *expsx = changeOneElement(se->elements, fieldi, newval);
-    StructLiteralExp * ee = new StructLiteralExp(se->loc, se->sd, expsx);
+    StructLiteralExp * ee = new (ctfeArena) StructLiteralExp(se->loc, se->sd, expsx);
     ee->type = se->type;
     ee->ownedByCtfe = OWNEDctfe;
     return ee;
@@ -1783,7 +2115,8 @@ UnionExp changeArrayLiteralLength(Loc loc, TypeArray *arrayType,
     if (oldval->op == TOKstring)
     {
         StringExp *oldse = (StringExp *)oldval;
-        void *s = mem.xcalloc(newlen + 1, oldse->sz);
+        void *s = CtfeArena::alloc((newlen + 1) * oldse->sz);
+        memset(s, 0, (newlen + 1) * oldse->sz);
         memcpy(s, oldse->string, copylen * oldse->sz);
         unsigned defaultValue = (unsigned)(defaultElem->toInteger());
         for (size_t elemi = copylen; elemi < newlen; ++elemi)
@@ -1818,7 +2151,7 @@ UnionExp changeArrayLiteralLength(Loc loc, TypeArray *arrayType,
              * we need to create a unique copy for each element
              */
             for (size_t i = copylen; i < newlen; i++)
-                (*elements)[i] = copyLiteral(defaultElem).copy();
+                (*elements)[i] = copyLiteral(defaultElem).ctfeCopy();
         }
         else
         {
@@ -2072,7 +2405,7 @@ UnionExp voidInitLiteral(Type *t, VarDeclaration *var)
     if (t->ty == Tsarray)
     {
         TypeSArray *tsa = (TypeSArray *)t;
-        Expression *elem = voidInitLiteral(tsa->next, var).copy();
+        Expression *elem = voidInitLiteral(tsa->next, var).ctfeCopy();
 
         // For aggregate value types (structs, static arrays) we must
         // create an a separate copy for each element.
@@ -2084,7 +2417,7 @@ UnionExp voidInitLiteral(Type *t, VarDeclaration *var)
         for (size_t i = 0; i < d; i++)
         {
             if (mustCopy && i > 0)
-                elem  = copyLiteral(elem).copy();
+                elem  = copyLiteral(elem).ctfeCopy();
             (*elements)[i] = elem;
         }
         new(&ue) ArrayLiteralExp(var->loc, elements);
@@ -2099,7 +2432,7 @@ UnionExp voidInitLiteral(Type *t, VarDeclaration *var)
         exps->setDim(ts->sym->fields.dim);
         for (size_t i = 0; i < ts->sym->fields.dim; i++)
         {
-            (*exps)[i] = voidInitLiteral(ts->sym->fields[i]->type, ts->sym->fields[i]).copy();
+            (*exps)[i] = voidInitLiteral(ts->sym->fields[i]->type, ts->sym->fields[i]).ctfeCopy();
         }
         new(&ue) StructLiteralExp(var->loc, ts->sym, exps);
         StructLiteralExp *se = (StructLiteralExp *)ue.exp();
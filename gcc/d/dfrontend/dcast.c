@@ -31,6 +31,9 @@ bool isCommutative(TOK op);
 MOD MODmerge(MOD mod1, MOD mod2);
 Expression *semantic(Expression *e, Scope *sc);
 
+int trackValueDependentMatches;
+unsigned valueDependentMatches;
+
 /* ==================== implicitCast ====================== */
 
 /**************************************
@@ -1374,6 +1377,16 @@ MATCH implicitConvTo(Expression *e, Type *t)
 
     ImplicitConvTo v(t);
     e->accept(&v);
+
+    /* Count matches that depend on the value of e rather than only on
+     * its type, such as integral narrowing or literal conversions, so
+     * that functionResolve() knows when not to cache its result.
+     */
+    if (trackValueDependentMatches && v.result != MATCHnomatch &&
+        (!e->type || e->type->implicitConvTo(t) != v.result))
+    {
+        valueDependentMatches++;
+    }
     return v.result;
 }
 
@@ -480,6 +480,8 @@ void AliasDeclaration::aliasSemantic(Scope *sc)
 
         if (!overloadInsert(sx))
             ScopeDsymbol::multiplyDefined(Loc(), sx, this);
+        else
+            overloadSetGrown(this, sx);
     }
 }
 
@@ -1936,7 +1938,7 @@ bool VarDeclaration::checkNestedReference(Scope *sc, Loc loc)
 
     //printf("\tfdv = %s\n", fdv->toChars());
     //printf("\tfdthis = %s\n", fdthis->toChars());
-    if (loc.filename)
+    if (loc.filename())
     {
         int lv = fdthis->getLevel(loc, sc, fdv);
         if (lv == -2)   // error
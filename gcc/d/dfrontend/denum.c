@@ -397,7 +397,7 @@ Lerrors:
 
 Type *EnumDeclaration::getMemtype(Loc loc)
 {
-    if (loc.linnum == 0)
+    if (loc.linnum() == 0)
         loc = this->loc;
     if (_scope)
     {
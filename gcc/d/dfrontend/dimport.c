@@ -238,7 +238,7 @@ void Import::semantic(Scope *sc)
     {
         // Modules need a list of each imported module
         //printf("%s imports %s\n", sc->_module->toChars(), mod->toChars());
-        sc->_module->aimports.push(mod);
+        sc->_module->addImport(mod);
 
         if (sc->explicitProtection)
             protection = sc->protection;
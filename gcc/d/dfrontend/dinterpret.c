@@ -756,11 +756,17 @@ Expression *ctfeInterpret(Expression *e)
     ctfeCodeGlobal.callingloc = e->loc;
     ctfeCodeGlobal.onExpression(e);
 
+    // Temporaries created while interpreting are freed when done, so
+    // the result has to be moved out of the arena first.
+    CtfeArena::enter();
     Expression *result = interpret(e, NULL);
     if (!CTFEExp::isCantExp(result))
         result = scrubReturnValue(e->loc, result);
     if (CTFEExp::isCantExp(result))
         result = new ErrorExp();
+    else
+        result = ctfeCopyOut(result);
+    CtfeArena::leave();
     return result;
 }
 
@@ -919,7 +925,7 @@ Expression *interpret(FuncDeclaration *fd, InterState *istate, Expressions *argu
              * copy them if they are passed as const
              */
             if (earg->op == TOKstructliteral && !(fparam->storageClass & (STCconst | STCimmutable)))
-                earg = copyLiteral(earg).copy();
+                earg = copyLiteral(earg).ctfeCopy();
         }
         if (earg->op == TOKthrownexception)
         {
@@ -1365,7 +1371,7 @@ public:
         }
 
         if (needToCopyLiteral(e))
-            e = copyLiteral(e).copy();
+            e = copyLiteral(e).ctfeCopy();
     #if LOGASSIGN
         printf("RETURN %s\n", s->loc.toChars());
         showCtfeExpr(e);
@@ -1894,7 +1900,7 @@ public:
             return;
 
         assert(e->op == TOKclassreference);
-        result = new ThrownExceptionExp(s->loc, (ClassReferenceExp *)e);
+        result = new (ctfeArena) ThrownExceptionExp(s->loc, (ClassReferenceExp *)e);
     }
 
     void visit(OnScopeStatement *s)
@@ -1928,7 +1934,7 @@ public:
 
         if (s->wthis->type->ty == Tpointer && s->exp->type->ty != Tpointer)
         {
-            e = new AddrExp(s->loc, e);
+            e = new (ctfeArena) AddrExp(s->loc, e);
             e->type = s->wthis->type;
         }
         ctfeStack.push(s->wthis);
@@ -2025,7 +2031,7 @@ public:
         {
             if (istate->fd->vthis)
             {
-                result = new VarExp(e->loc, istate->fd->vthis);
+                result = new (ctfeArena) VarExp(e->loc, istate->fd->vthis);
                 result->type = e->type;
             }
             else
@@ -2145,7 +2151,7 @@ public:
             if (val->type->ty == Tsarray && pointee->ty == Tarray &&
                 elemsize == pointee->nextOf()->size())
             {
-                result = new AddrExp(e->loc, val);
+                result = new (ctfeArena) AddrExp(e->loc, val);
                 result->type = e->type;
                 return;
             }
@@ -2155,13 +2161,13 @@ public:
                 elemsize == pointee->nextOf()->size())
             {
                 size_t d = (size_t)((TypeSArray *)pointee)->dim->toInteger();
-                Expression *elwr = new IntegerExp(e->loc, e->offset / elemsize,     Type::tsize_t);
-                Expression *eupr = new IntegerExp(e->loc, e->offset / elemsize + d, Type::tsize_t);
+                Expression *elwr = new (ctfeArena) IntegerExp(e->loc, e->offset / elemsize,     Type::tsize_t);
+                Expression *eupr = new (ctfeArena) IntegerExp(e->loc, e->offset / elemsize + d, Type::tsize_t);
 
                 // Create a CTFE pointer &val[ofs..ofs+d]
-                result = new SliceExp(e->loc, val, elwr, eupr);
+                result = new (ctfeArena) SliceExp(e->loc, val, elwr, eupr);
                 result->type = pointee;
-                result = new AddrExp(e->loc, result);
+                result = new (ctfeArena) AddrExp(e->loc, result);
                 result->type = e->type;
                 return;
             }
@@ -2172,9 +2178,9 @@ public:
                 if (e->offset == 0 && isSafePointerCast(e->var->type, pointee))
                 {
                     // Create a CTFE pointer &var
-                    result = new VarExp(e->loc, e->var);
+                    result = new (ctfeArena) VarExp(e->loc, e->var);
                     result->type = elemtype;
-                    result = new AddrExp(e->loc, result);
+                    result = new (ctfeArena) AddrExp(e->loc, result);
                     result->type = e->type;
                     return;
                 }
@@ -2201,10 +2207,10 @@ public:
             if (aggregate)
             {
                 // Create a CTFE pointer &aggregate[ofs]
-                IntegerExp *ofs = new IntegerExp(e->loc, indx, Type::tsize_t);
-                result = new IndexExp(e->loc, aggregate, ofs);
+                IntegerExp *ofs = new (ctfeArena) IntegerExp(e->loc, indx, Type::tsize_t);
+                result = new (ctfeArena) IndexExp(e->loc, aggregate, ofs);
                 result->type = elemtype;
-                result = new AddrExp(e->loc, result);
+                result = new (ctfeArena) AddrExp(e->loc, result);
                 result->type = e->type;
                 return;
             }
@@ -2212,9 +2218,9 @@ public:
         else if (e->offset == 0 && isSafePointerCast(e->var->type, pointee))
         {
             // Create a CTFE pointer &var
-            VarExp *ve = new VarExp(e->loc, e->var);
+            VarExp *ve = new (ctfeArena) VarExp(e->loc, e->var);
             ve->type = e->var->type;
-            result = new AddrExp(e->loc, ve);
+            result = new (ctfeArena) AddrExp(e->loc, ve);
             result->type = e->type;
             return;
         }
@@ -2232,7 +2238,7 @@ public:
         {
             // Normally this is already done by optimize()
             // Do it here in case optimize(WANTvalue) wasn't run before CTFE
-            result = new SymOffExp(e->loc, ((VarExp *)e->e1)->var, 0);
+            result = new (ctfeArena) SymOffExp(e->loc, ((VarExp *)e->e1)->var, 0);
             result->type = e->type;
             return;
         }
@@ -2243,7 +2249,7 @@ public:
             return;
 
         // Return a simplified address expression
-        result = new AddrExp(e->loc, result);
+        result = new (ctfeArena) AddrExp(e->loc, result);
         result->type = e->type;
     }
 
@@ -2273,7 +2279,7 @@ public:
         }
         else
         {
-            result = new DelegateExp(e->loc, result, e->func, false);
+            result = new (ctfeArena) DelegateExp(e->loc, result, e->func, false);
             result->type = e->type;
         }
     }
@@ -2286,7 +2292,7 @@ public:
             /* Magic variable __ctfe always returns true when interpreting
              */
             if (v->ident == Id::ctfe)
-                return new IntegerExp(loc, 1, Type::tbool);
+                return new (ctfeArena) IntegerExp(loc, 1, Type::tbool);
 
             if (!v->originalType && v->_scope)   // semantic() not yet run
             {
@@ -2512,7 +2518,7 @@ public:
                         }
                         else if (v2->_init->isVoidInitializer())
                         {
-                            einit = voidInitLiteral(v2->type, v2).copy();
+                            einit = voidInitLiteral(v2->type, v2).ctfeCopy();
                         }
                         else
                         {
@@ -2541,7 +2547,7 @@ public:
                 }
                 else if (v->_init->isVoidInitializer())
                 {
-                    result = voidInitLiteral(v->type, v).copy();
+                    result = voidInitLiteral(v->type, v).ctfeCopy();
                     // There is no AssignExp for void initializers,
                     // so set it here.
                     setValue(v, result);
@@ -2627,7 +2633,7 @@ public:
             ClassDeclaration *cd = ((ClassReferenceExp *)result)->originalClass();
             assert(cd);
 
-            result = new TypeidExp(e->loc, cd->type);
+            result = new (ctfeArena) TypeidExp(e->loc, cd->type);
             result->type = e->type;
             return;
         }
@@ -2679,7 +2685,7 @@ public:
         }
         if (expsx)
         {
-            TupleExp *te = new TupleExp(e->loc, expsx);
+            TupleExp *te = new (ctfeArena) TupleExp(e->loc, expsx);
             expandTuples(te->exps);
             te->type = new TypeTuple(te->exps);
             result = te;
@@ -2715,7 +2721,7 @@ public:
             Expression *ex;
             if (!exp)
             {
-                ex = copyLiteral(basis).copy();
+                ex = copyLiteral(basis).ctfeCopy();
                 goto Lcow;
             }
 
@@ -2731,7 +2737,7 @@ public:
              *  int[1][] pieces = [z,z];    // here
              */
             if (wantCopy || ex == exp && expsx)
-                ex = copyLiteral(ex).copy();
+                ex = copyLiteral(ex).ctfeCopy();
 
             if (ex == exp && !expsx)
                 continue;
@@ -2749,7 +2755,7 @@ public:
                     Expression *el = (*e->elements)[j];
                     if (!el)
                         el = e->basis;
-                    (*expsx)[j] = copyLiteral(el).copy();
+                    (*expsx)[j] = copyLiteral(el).ctfeCopy();
                 }
             }
             (*expsx)[i] = ex;
@@ -2764,7 +2770,7 @@ public:
                 result = CTFEExp::cantexp;
                 return;
             }
-            ArrayLiteralExp *ae = new ArrayLiteralExp(e->loc, basis, expsx);
+            ArrayLiteralExp *ae = new (ctfeArena) ArrayLiteralExp(e->loc, basis, expsx);
             ae->type = e->type;
             ae->ownedByCtfe = OWNEDctfe;
             result = ae;
@@ -2776,7 +2782,7 @@ public:
             result = e;
             return;
         }
-        result = copyLiteral(e).copy();
+        result = copyLiteral(e).ctfeCopy();
     }
 
     void visit(AssocArrayLiteralExp *e)
@@ -2861,13 +2867,13 @@ public:
         if (keysx != e->keys || valuesx != e->values)
         {
             AssocArrayLiteralExp *ae;
-            ae = new AssocArrayLiteralExp(e->loc, keysx, valuesx);
+            ae = new (ctfeArena) AssocArrayLiteralExp(e->loc, keysx, valuesx);
             ae->type = e->type;
             ae->ownedByCtfe = OWNEDctfe;
             result = ae;
             return;
         }
-        result = copyLiteral(e).copy();
+        result = copyLiteral(e).ctfeCopy();
     }
 
     void visit(StructLiteralExp *e)
@@ -2896,7 +2902,7 @@ public:
                 if (i == e->sd->fields.dim - 1 && e->sd->isNested())
                 {
                     // Context field has not been filled
-                    ex = new NullExp(e->loc);
+                    ex = new (ctfeArena) NullExp(e->loc);
                     ex->type = v->type;
                 }
             }
@@ -2905,7 +2911,7 @@ public:
                 exp = (*e->elements)[i];
                 if (!exp)
                 {
-                    ex = voidInitLiteral(v->type, v).copy();
+                    ex = voidInitLiteral(v->type, v).ctfeCopy();
                 }
                 else
                 {
@@ -2949,13 +2955,13 @@ public:
                 result = CTFEExp::cantexp;
                 return;
             }
-            StructLiteralExp *se = new StructLiteralExp(e->loc, e->sd, expsx);
+            StructLiteralExp *se = new (ctfeArena) StructLiteralExp(e->loc, e->sd, expsx);
             se->type = e->type;
             se->ownedByCtfe = OWNEDctfe;
             result = se;
             return;
         }
-        result = copyLiteral(e).copy();
+        result = copyLiteral(e).ctfeCopy();
     }
 
     // Create an array literal of type 'newtype' with dimensions given by
@@ -2978,8 +2984,8 @@ public:
             Expressions *elements = new Expressions();
             elements->setDim(len);
             for (size_t i = 0; i < len; i++)
-                 (*elements)[i] = copyLiteral(elem).copy();
-            ArrayLiteralExp *ae = new ArrayLiteralExp(loc, elements);
+                 (*elements)[i] = copyLiteral(elem).ctfeCopy();
+            ArrayLiteralExp *ae = new (ctfeArena) ArrayLiteralExp(loc, elements);
             ae->type = newtype;
             ae->ownedByCtfe = OWNEDctfe;
             return ae;
@@ -3052,14 +3058,14 @@ public:
                 }
                 sd->fill(e->loc, exps, false);
 
-                StructLiteralExp *se = new StructLiteralExp(e->loc, sd, exps, e->newtype);
+                StructLiteralExp *se = new (ctfeArena) StructLiteralExp(e->loc, sd, exps, e->newtype);
                 se->type = e->newtype;
                 se->ownedByCtfe = OWNEDctfe;
                 result = interpret(se, istate);
             }
             if (exceptionOrCant(result))
                 return;
-            result = new AddrExp(e->loc, result);
+            result = new (ctfeArena) AddrExp(e->loc, result);
             result->type = e->type;
             return;
         }
@@ -3088,7 +3094,7 @@ public:
                     if (v->_init)
                     {
                         if (v->_init->isVoidInitializer())
-                            m = voidInitLiteral(v->type, v).copy();
+                            m = voidInitLiteral(v->type, v).ctfeCopy();
                         else
                             m = v->getConstInitializer(true);
                     }
@@ -3096,14 +3102,14 @@ public:
                         m = v->type->defaultInitLiteral(e->loc);
                     if (exceptionOrCant(m))
                         return;
-                    (*elems)[fieldsSoFar+i] = copyLiteral(m).copy();
+                    (*elems)[fieldsSoFar+i] = copyLiteral(m).ctfeCopy();
                 }
             }
             // Hack: we store a ClassDeclaration instead of a StructDeclaration.
             // We probably won't get away with this.
-            StructLiteralExp *se = new StructLiteralExp(e->loc, (StructDeclaration *)cd, elems, e->newtype);
+            StructLiteralExp *se = new (ctfeArena) StructLiteralExp(e->loc, (StructDeclaration *)cd, elems, e->newtype);
             se->ownedByCtfe = OWNEDctfe;
-            Expression *eref = new ClassReferenceExp(e->loc, se, e->type);
+            Expression *eref = new (ctfeArena) ClassReferenceExp(e->loc, se, e->type);
             if (e->member)
             {
                 // Call constructor
@@ -3149,13 +3155,13 @@ public:
             Expressions *elements = new Expressions();
             elements->setDim(1);
             (*elements)[0] = newval;
-            ArrayLiteralExp *ae = new ArrayLiteralExp(e->loc, elements);
+            ArrayLiteralExp *ae = new (ctfeArena) ArrayLiteralExp(e->loc, elements);
             ae->type = e->newtype->arrayOf();
             ae->ownedByCtfe = OWNEDctfe;
 
-            result = new IndexExp(e->loc, ae, new IntegerExp(Loc(), 0, Type::tsize_t));
+            result = new (ctfeArena) IndexExp(e->loc, ae, new (ctfeArena) IntegerExp(Loc(), 0, Type::tsize_t));
             result->type = e->newtype;
-            result = new AddrExp(e->loc, result);
+            result = new (ctfeArena) AddrExp(e->loc, result);
             result->type = e->type;
             return;
         }
@@ -3180,7 +3186,7 @@ public:
             case TOKvector: result = e;             return; // do nothing
             default:        assert(0);
         }
-        result = ue.copy();
+        result = ue.ctfeCopy();
     }
 
     void visit(DotTypeExp *e)
@@ -3196,7 +3202,7 @@ public:
             result = e;  // optimize: reuse this CTFE reference
         else
         {
-            result = e->copy();
+            result = ctfeCopy(e);
             ((DotTypeExp *)result)->e1 = e1;
         }
     }
@@ -3232,7 +3238,7 @@ public:
             Expression *e2 = interpret(e->e2, istate);
             if (exceptionOrCant(e2))
                 return;
-            result = pointerDifference(e->loc, e->type, e1, e2).copy();
+            result = pointerDifference(e->loc, e->type, e1, e2).ctfeCopy();
             return;
         }
         if (e->e1->type->ty == Tpointer && e->e2->type->isintegral())
@@ -3243,7 +3249,7 @@ public:
             Expression *e2 = interpret(e->e2, istate);
             if (exceptionOrCant(e2))
                 return;
-            result = pointerArithmetic(e->loc, e->op, e->type, e1, e2).copy();
+            result = pointerArithmetic(e->loc, e->op, e->type, e1, e2).ctfeCopy();
             return;
         }
         if (e->e2->type->ty == Tpointer && e->e1->type->isintegral() && e->op == TOKadd)
@@ -3254,7 +3260,7 @@ public:
             Expression *e2 = interpret(e->e2, istate);
             if (exceptionOrCant(e2))
                 return;
-            result = pointerArithmetic(e->loc, e->op, e->type, e2, e1).copy();
+            result = pointerArithmetic(e->loc, e->op, e->type, e2, e1).ctfeCopy();
             return;
         }
         if (e->e1->type->ty == Tpointer || e->e2->type->ty == Tpointer)
@@ -3282,7 +3288,7 @@ public:
                 return;
             }
         }
-        result = (*fp)(e->type, e1, e2).copy();
+        result = (*fp)(e->type, e1, e2).ctfeCopy();
         if (CTFEExp::isCantExp(result))
             e->error("%s cannot be interpreted at compile time", e->toChars());
     }
@@ -3316,7 +3322,7 @@ public:
                 result = CTFEExp::cantexp;
                 return;
             }
-            result = new IntegerExp(e->loc, cmp, e->type);
+            result = new (ctfeArena) IntegerExp(e->loc, cmp, e->type);
             return;
         }
         Expression *e1 = interpret(e->e1, istate);
@@ -3338,7 +3344,7 @@ public:
             return;
         }
         int cmp = (*fp)(e->loc, e->op, e1, e2);
-        result = new IntegerExp(e->loc, cmp, e->type);
+        result = new (ctfeArena) IntegerExp(e->loc, cmp, e->type);
     }
 
     void visit(BinExp *e)
@@ -3544,7 +3550,7 @@ public:
                         // Doesn't exist yet, create an empty AA...
                         Expressions *keysx = new Expressions();
                         Expressions *valuesx = new Expressions();
-                        newAA = new AssocArrayLiteralExp(e->loc, keysx, valuesx);
+                        newAA = new (ctfeArena) AssocArrayLiteralExp(e->loc, keysx, valuesx);
                         newAA->type = xe->type;
                         newAA->ownedByCtfe = OWNEDctfe;
                         //... and insert it into the existing AA.
@@ -3559,7 +3565,7 @@ public:
                 {
                     oldval = findKeyInAA(e->loc, existingAA, lastIndex);
                     if (!oldval)
-                        oldval = copyLiteral(e->e1->type->defaultInitLiteral(e->loc)).copy();
+                        oldval = copyLiteral(e->e1->type->defaultInitLiteral(e->loc)).ctfeCopy();
                 }
             }
             else
@@ -3572,7 +3578,7 @@ public:
                  *     aa = [i:[j:T.init]];
                  *     aa[j] op= newval;
                  */
-                oldval = copyLiteral(e->e1->type->defaultInitLiteral(e->loc)).copy();
+                oldval = copyLiteral(e->e1->type->defaultInitLiteral(e->loc)).ctfeCopy();
 
                 Expression *newaae = oldval;
                 while (e1->op == TOKindex && ((IndexExp *)e1)->e1->type->toBasetype()->ty == Taarray)
@@ -3585,7 +3591,7 @@ public:
                     Expressions *valuesx = new Expressions();
                     keysx->push(ekey);
                     valuesx->push(newaae);
-                    AssocArrayLiteralExp *aae = new AssocArrayLiteralExp(e->loc, keysx, valuesx);
+                    AssocArrayLiteralExp *aae = new (ctfeArena) AssocArrayLiteralExp(e->loc, keysx, valuesx);
                     aae->type = ((IndexExp *)e1)->e1->type;
                     aae->ownedByCtfe = OWNEDctfe;
                     if (!existingAA)
@@ -3704,7 +3710,7 @@ public:
                     // we can skip duplication, because it gets copied later anyway.
                     if (newval->type->ty != Tarray)
                     {
-                        newval = copyLiteral(newval).copy();
+                        newval = copyLiteral(newval).ctfeCopy();
                         newval->type = e->e2->type; // repaint type
                     }
                     else
@@ -3715,7 +3721,7 @@ public:
                 }
                 oldval = resolveSlice(oldval);
 
-                newval = (*fp)(e->type, oldval, newval).copy();
+                newval = (*fp)(e->type, oldval, newval).ctfeCopy();
             }
             else if (e->e2->type->isintegral() &&
                 (e->op == TOKaddass ||
@@ -3723,7 +3729,7 @@ public:
                  e->op == TOKplusplus ||
                  e->op == TOKminusminus))
             {
-                newval = pointerArithmetic(e->loc, e->op, e->type, oldval, newval).copy();
+                newval = pointerArithmetic(e->loc, e->op, e->type, oldval, newval).ctfeCopy();
             }
             else
             {
@@ -3791,7 +3797,7 @@ public:
             if (oldlen != 0)    // Get the old array literal.
                 oldval = interpret(e1, istate);
             newval = changeArrayLiteralLength(e->loc, (TypeArray *)t, oldval,
-                oldlen,  newlen).copy();
+                oldlen,  newlen).ctfeCopy();
 
             e1 = assignToLvalue(e, e1, newval);
             if (exceptionOrCant(e1))
@@ -3882,7 +3888,7 @@ public:
                 continue;
             Expression *e = (*sle->elements)[i];
             if (e->op != TOKvoid)
-                (*sle->elements)[i] = voidInitLiteral(e->type, v).copy();
+                (*sle->elements)[i] = voidInitLiteral(e->type, v).ctfeCopy();
         }
     }
 
@@ -3994,7 +4000,7 @@ public:
 
         if (newval->op == TOKstructliteral && oldval)
         {
-            newval = copyLiteral(newval).copy();
+            newval = copyLiteral(newval).ctfeCopy();
             assignInPlace(oldval, newval);
         }
         else if (wantCopy && e->op == TOKassign)
@@ -4040,7 +4046,7 @@ public:
         {
             // e1 has its own payload, so we have to create a new literal.
             if (wantCopy)
-                newval = copyLiteral(newval).copy();
+                newval = copyLiteral(newval).ctfeCopy();
 
             if (t1b->ty == Tsarray && e->op == TOKconstruct && e->e2->isLvalue())
             {
@@ -4103,7 +4109,7 @@ public:
             uinteger_t dollar = resolveArrayLength(oldval);
             if (se->lengthVar)
             {
-                Expression *dollarExp = new IntegerExp(e1->loc, dollar, Type::tsize_t);
+                Expression *dollarExp = new (ctfeArena) IntegerExp(e1->loc, dollar, Type::tsize_t);
                 ctfeStack.push(se->lengthVar);
                 setValue(se->lengthVar, dollarExp);
             }
@@ -4254,9 +4260,9 @@ public:
             }
             if (goal == ctfeNeedNothing)
                 return NULL; // avoid creating an unused literal
-            SliceExp *retslice = new SliceExp(e->loc, existingSE,
-                new IntegerExp(e->loc, firstIndex, Type::tsize_t),
-                new IntegerExp(e->loc, firstIndex + upperbound - lowerbound, Type::tsize_t));
+            SliceExp *retslice = new (ctfeArena) SliceExp(e->loc, existingSE,
+                new (ctfeArena) IntegerExp(e->loc, firstIndex, Type::tsize_t),
+                new (ctfeArena) IntegerExp(e->loc, firstIndex + upperbound - lowerbound, Type::tsize_t));
             retslice->type = e->type;
             return interpret(retslice, istate);
         }
@@ -4300,7 +4306,7 @@ public:
                         {
                             Expression *oldelem = (*oldelems)[(size_t)(i + firstIndex)];
                             Expression *newelem = (*newelems)[(size_t)(i + srclower)];
-                            newelem = copyLiteral(newelem).copy();
+                            newelem = copyLiteral(newelem).ctfeCopy();
                             newelem->type = elemtype;
                             if (needsPostblit)
                             {
@@ -4319,7 +4325,7 @@ public:
                         {
                             Expression *oldelem = (*oldelems)[(size_t)(i + firstIndex)];
                             Expression *newelem = (*newelems)[(size_t)(i + srclower)];
-                            newelem = copyLiteral(newelem).copy();
+                            newelem = copyLiteral(newelem).ctfeCopy();
                             newelem->type = elemtype;
                             if (needsPostblit)
                             {
@@ -4429,7 +4435,7 @@ public:
                         else
                         {
                             Expression *oldelem = (*w)[k];
-                            Expression *tmpelem = needsDtor ? copyLiteral(oldelem).copy() : NULL;
+                            Expression *tmpelem = needsDtor ? copyLiteral(oldelem).ctfeCopy() : NULL;
 
                             assignInPlace(oldelem, newval);
 
@@ -4470,9 +4476,9 @@ public:
 
             if (goal == ctfeNeedNothing)
                 return NULL; // avoid creating an unused literal
-            SliceExp *retslice = new SliceExp(e->loc, existingAE,
-                new IntegerExp(e->loc, firstIndex, Type::tsize_t),
-                new IntegerExp(e->loc, firstIndex + upperbound - lowerbound, Type::tsize_t));
+            SliceExp *retslice = new (ctfeArena) SliceExp(e->loc, existingAE,
+                new (ctfeArena) IntegerExp(e->loc, firstIndex, Type::tsize_t),
+                new (ctfeArena) IntegerExp(e->loc, firstIndex + upperbound - lowerbound, Type::tsize_t));
             retslice->type = e->type;
             return interpret(retslice, istate);
         }
@@ -4670,7 +4676,7 @@ public:
                 (dir1 != dir2 && pointToSameMemoryBlock(agg1, agg3) && pointToSameMemoryBlock(agg2, agg4)))
             {
                 // it's a legal two-sided comparison
-                result = new IntegerExp(e->loc, (e->op == TOKandand) ?  0 : 1, e->type);
+                result = new (ctfeArena) IntegerExp(e->loc, (e->op == TOKandand) ?  0 : 1, e->type);
                 return;
             }
             // It's an invalid four-pointer comparison. Either the second
@@ -4708,7 +4714,7 @@ public:
             result = interpret(e->e2, istate);
             return;
         }
-        result = new IntegerExp(e->loc, (e->op == TOKandand) ? 0 : 1, e->type);
+        result = new (ctfeArena) IntegerExp(e->loc, (e->op == TOKandand) ? 0 : 1, e->type);
     }
 
     void visit(AndAndExp *e)
@@ -4758,7 +4764,7 @@ public:
             return;
         }
         if (goal != ctfeNeedNothing)
-            result = new IntegerExp(e->loc, res, e->type);
+            result = new (ctfeArena) IntegerExp(e->loc, res, e->type);
     }
 
     void visit(OrOrExp *e)
@@ -4808,7 +4814,7 @@ public:
             return;
         }
         if (goal != ctfeNeedNothing)
-            result = new IntegerExp(e->loc, res, e->type);
+            result = new (ctfeArena) IntegerExp(e->loc, res, e->type);
     }
 
     // Print a stack trace, starting from callingExp which called fd.
@@ -5063,7 +5069,7 @@ public:
             ctfeStack.push(v);
             if (!v->_init && !getValue(v))
             {
-                setValue(v, copyLiteral(v->type->defaultInitLiteral(e->loc)).copy());
+                setValue(v, copyLiteral(v->type->defaultInitLiteral(e->loc)).ctfeCopy());
             }
             if (!getValue(v))
             {
@@ -5077,7 +5083,7 @@ public:
                 if (newval->op != TOKvoidexp)
                 {
                     // v isn't necessarily null.
-                    setValueWithoutChecking(v, copyLiteral(newval).copy());
+                    setValueWithoutChecking(v, copyLiteral(newval).ctfeCopy());
                 }
             }
             result = interpret(e->e2, istate, goal);
@@ -5106,7 +5112,7 @@ public:
             if (exceptionOrCant(result))
                 return;
             if (result->op != TOKnull)
-                result = new IntegerExp(e->loc, 1, Type::tbool);
+                result = new (ctfeArena) IntegerExp(e->loc, 1, Type::tbool);
         }
         else
             result = interpret(e->econd, istate);
@@ -5142,7 +5148,7 @@ public:
             result = CTFEExp::cantexp;
             return;
         }
-        result = new IntegerExp(e->loc, resolveArrayLength(e1), e->type);
+        result = new (ctfeArena) IntegerExp(e->loc, resolveArrayLength(e1), e->type);
     }
 
     void visit(DelegatePtrExp *e)
@@ -5257,7 +5263,7 @@ public:
         dinteger_t len = resolveArrayLength(e1);
         if (e->lengthVar)
         {
-            Expression *dollarExp = new IntegerExp(e->loc, len, Type::tsize_t);
+            Expression *dollarExp = new (ctfeArena) IntegerExp(e->loc, len, Type::tsize_t);
             ctfeStack.push(e->lengthVar);
             setValue(e->lengthVar, dollarExp);
         }
@@ -5321,8 +5327,8 @@ public:
                 {
                     // if we need a reference, IndexExp shouldn't be interpreting
                     // the expression to a value, it should stay as a reference
-                    result = new IndexExp(e->loc, agg,
-                        new IntegerExp(e->e2->loc, indexToAccess, e->e2->type));
+                    result = new (ctfeArena) IndexExp(e->loc, agg,
+                        new (ctfeArena) IntegerExp(e->e2->loc, indexToAccess, e->e2->type));
                     result->type = e->type;
                     return;
                 }
@@ -5367,7 +5373,7 @@ public:
                     result = e;
                 else
                 {
-                    result = new IndexExp(e->loc, e1, e2);
+                    result = new (ctfeArena) IndexExp(e->loc, e1, e2);
                     result->type = e->type;
                 }
                 return;
@@ -5395,8 +5401,8 @@ public:
 
         if (goal == ctfeNeedLvalue)
         {
-            Expression *e2 = new IntegerExp(e->e2->loc, indexToAccess, Type::tsize_t);
-            result = new IndexExp(e->loc, agg, e2);
+            Expression *e2 = new (ctfeArena) IntegerExp(e->e2->loc, indexToAccess, Type::tsize_t);
+            result = new (ctfeArena) IndexExp(e->loc, agg, e2);
             result->type = e->type;
             return;
         }
@@ -5453,7 +5459,7 @@ public:
             {
                 if (iupr == ilwr)
                 {
-                    result = new NullExp(e->loc);
+                    result = new (ctfeArena) NullExp(e->loc);
                     result->type = e->type;
                     return;
                 }
@@ -5486,10 +5492,10 @@ public:
             }
             if (ofs != 0)
             {
-                lwr = new IntegerExp(e->loc, ilwr, lwr->type);
-                upr = new IntegerExp(e->loc, iupr, upr->type);
+                lwr = new (ctfeArena) IntegerExp(e->loc, ilwr, lwr->type);
+                upr = new (ctfeArena) IntegerExp(e->loc, iupr, upr->type);
             }
-            result = new SliceExp(e->loc, agg, lwr, upr);
+            result = new (ctfeArena) SliceExp(e->loc, agg, lwr, upr);
             result->type = e->type;
             return;
         }
@@ -5518,7 +5524,7 @@ public:
         uinteger_t dollar = resolveArrayLength(e1);
         if (e->lengthVar)
         {
-            IntegerExp *dollarExp = new IntegerExp(e->loc, dollar, Type::tsize_t);
+            IntegerExp *dollarExp = new (ctfeArena) IntegerExp(e->loc, dollar, Type::tsize_t);
             ctfeStack.push(e->lengthVar);
             setValue(e->lengthVar, dollarExp);
         }
@@ -5571,9 +5577,9 @@ public:
             }
             ilwr += lo1;
             iupr += lo1;
-            result = new SliceExp(e->loc, se->e1,
-                    new IntegerExp(e->loc, ilwr, lwr->type),
-                    new IntegerExp(e->loc, iupr, upr->type));
+            result = new (ctfeArena) SliceExp(e->loc, se->e1,
+                    new (ctfeArena) IntegerExp(e->loc, ilwr, lwr->type),
+                    new (ctfeArena) IntegerExp(e->loc, iupr, upr->type));
             result->type = e->type;
             return;
         }
@@ -5586,7 +5592,7 @@ public:
                 return;
             }
         }
-        result = new SliceExp(e->loc, e1, lwr, upr);
+        result = new (ctfeArena) SliceExp(e->loc, e1, lwr, upr);
         result->type = e->type;
     }
 
@@ -5603,7 +5609,7 @@ public:
             return;
         if (e2->op == TOKnull)
         {
-            result = new NullExp(e->loc, e->type);
+            result = new (ctfeArena) NullExp(e->loc, e->type);
             return;
         }
         if (e2->op != TOKassocarrayliteral)
@@ -5618,14 +5624,14 @@ public:
             return;
         if (!result)
         {
-            result = new NullExp(e->loc, e->type);
+            result = new (ctfeArena) NullExp(e->loc, e->type);
         }
         else
         {
             // Create a CTFE pointer &aa[index]
-            result = new IndexExp(e->loc, e2, e1);
+            result = new (ctfeArena) IndexExp(e->loc, e2, e1);
             result->type = e->type->nextOf();
-            result = new AddrExp(e->loc, result);
+            result = new (ctfeArena) AddrExp(e->loc, result);
             result->type = e->type;
         }
     }
@@ -5643,7 +5649,7 @@ public:
             return;
         e1 = resolveSlice(e1);
         e2 = resolveSlice(e2);
-        result = ctfeCat(e->type, e1, e2).copy();
+        result = ctfeCat(e->type, e1, e2).ctfeCopy();
         if (CTFEExp::isCantExp(result))
         {
             e->error("%s cannot be interpreted at compile time", e->toChars());
@@ -5727,18 +5733,18 @@ public:
                     return;
                 }
                 // Create a CTFE pointer &aggregate[1..2]
-                result = new IndexExp(e->loc, ((SliceExp *)e1)->e1, ((SliceExp *)e1)->lwr);
+                result = new (ctfeArena) IndexExp(e->loc, ((SliceExp *)e1)->e1, ((SliceExp *)e1)->lwr);
                 result->type = e->type->nextOf();
-                result = new AddrExp(e->loc, result);
+                result = new (ctfeArena) AddrExp(e->loc, result);
                 result->type = e->type;
                 return;
             }
             if (e1->op == TOKarrayliteral || e1->op == TOKstring)
             {
                 // Create a CTFE pointer &[1,2,3][0] or &"abc"[0]
-                result = new IndexExp(e->loc, e1, new IntegerExp(e->loc, 0, Type::tsize_t));
+                result = new (ctfeArena) IndexExp(e->loc, e1, new (ctfeArena) IntegerExp(e->loc, 0, Type::tsize_t));
                 result->type = e->type->nextOf();
-                result = new AddrExp(e->loc, result);
+                result = new (ctfeArena) AddrExp(e->loc, result);
                 result->type = e->type;
                 return;
             }
@@ -5746,7 +5752,7 @@ public:
             {
                 // type painting operation
                 IndexExp *ie = (IndexExp *)e1;
-                result = new IndexExp(e1->loc, ie->e1, ie->e2);
+                result = new (ctfeArena) IndexExp(e1->loc, ie->e1, ie->e2);
                 if (castBackFromVoid)
                 {
                     // get the original type. For strings, it's just the type...
@@ -5782,7 +5788,7 @@ public:
                 Type *origType = ((AddrExp *)e1)->e1->type;
                 if (isSafePointerCast(origType, pointee))
                 {
-                    result = new AddrExp(e->loc, ((AddrExp *)e1)->e1);
+                    result = new (ctfeArena) AddrExp(e->loc, ((AddrExp *)e1)->e1);
                     result->type = e->type;
                     return;
                 }
@@ -5793,12 +5799,12 @@ public:
                     dinteger_t dim = ((TypeSArray *)pointee->toBasetype())->dim->toInteger();
                     IndexExp *ie = (IndexExp *)((AddrExp *)e1)->e1;
                     Expression *lwr = ie->e2;
-                    Expression *upr = new IntegerExp(ie->e2->loc, ie->e2->toInteger() + dim, Type::tsize_t);
+                    Expression *upr = new (ctfeArena) IntegerExp(ie->e2->loc, ie->e2->toInteger() + dim, Type::tsize_t);
 
                     // Create a CTFE pointer &val[idx..idx+dim]
-                    result = new SliceExp(e->loc, ie->e1, lwr, upr);
+                    result = new (ctfeArena) SliceExp(e->loc, ie->e1, lwr, upr);
                     result->type = pointee;
-                    result = new AddrExp(e->loc, result);
+                    result = new (ctfeArena) AddrExp(e->loc, result);
                     result->type = e->type;
                     return;
                 }
@@ -5815,9 +5821,9 @@ public:
                     return;
                 }
                 if (e1->op == TOKvar)
-                    result = new VarExp(e->loc, ((VarExp *)e1)->var);
+                    result = new (ctfeArena) VarExp(e->loc, ((VarExp *)e1)->var);
                 else
-                    result = new SymOffExp(e->loc, ((SymOffExp *)e1)->var, ((SymOffExp *)e1)->offset);
+                    result = new (ctfeArena) SymOffExp(e->loc, ((SymOffExp *)e1)->var, ((SymOffExp *)e1)->offset);
                 result->type = e->to;
                 return;
             }
@@ -5853,7 +5859,7 @@ public:
                 result = CTFEExp::cantexp;
                 return;
             }
-            e1 = new SliceExp(e1->loc, se->e1, se->lwr, se->upr);
+            e1 = new (ctfeArena) SliceExp(e1->loc, se->e1, se->lwr, se->upr);
             e1->type = e->to;
             result = e1;
             return;
@@ -5872,7 +5878,7 @@ public:
             e1 = resolveSlice(e1);
         if (e->to->toBasetype()->ty == Tbool && e1->type->ty == Tpointer)
         {
-            result = new IntegerExp(e->loc, e1->op != TOKnull, e->to);
+            result = new (ctfeArena) IntegerExp(e->loc, e1->op != TOKnull, e->to);
             return;
         }
         result = ctfeCast(e->loc, e->type, e->to, e1);
@@ -6025,7 +6031,7 @@ public:
                 result = e; // optimize: reuse this CTFE reference
             else
             {
-                result = new DotVarExp(e->loc, ex, f, false);
+                result = new (ctfeArena) DotVarExp(e->loc, ex, f, false);
                 result->type = e->type;
             }
             return;
@@ -6080,13 +6086,13 @@ public:
         {
             Expression *ev = (*se->elements)[i];
             if (!ev || ev->op == TOKvoid)
-                (*se->elements)[i] = voidInitLiteral(e->type, v).copy();
+                (*se->elements)[i] = voidInitLiteral(e->type, v).ctfeCopy();
             // just return the (simplified) dotvar expression as a CTFE reference
             if (e->e1 == ex)
                 result = e;
             else
             {
-                result = new DotVarExp(e->loc, ex, v);
+                result = new (ctfeArena) DotVarExp(e->loc, ex, v);
                 result->type = e->type;
             }
             return;
@@ -6163,7 +6169,7 @@ public:
         }
         valuesx->dim = valuesx->dim - removed;
         keysx->dim = keysx->dim - removed;
-        result = new IntegerExp(e->loc, removed ? 1 : 0, Type::tbool);
+        result = new (ctfeArena) IntegerExp(e->loc, removed ? 1 : 0, Type::tbool);
     }
 
     void visit(ClassReferenceExp *e)
@@ -6239,7 +6245,7 @@ Expression *scrubReturnValue(Loc loc, Expression *e)
     if (e->op == TOKvoid)
     {
         error(loc, "uninitialized variable '%s' cannot be returned from CTFE", ((VoidInitExp *)e)->var->toChars());
-        return new ErrorExp();
+        return new (ctfeArena) ErrorExp();
     }
     e = resolveSlice(e);
     if (e->op == TOKstructliteral)
@@ -6408,7 +6414,7 @@ Expression *interpret_length(InterState *istate, Expression *earg)
         len = ((AssocArrayLiteralExp *)earg)->keys->dim;
     else
         assert(earg->op == TOKnull);
-    Expression *e = new IntegerExp(earg->loc, len, Type::tsize_t);
+    Expression *e = new (ctfeArena) IntegerExp(earg->loc, len, Type::tsize_t);
     return e;
 }
 
@@ -6421,15 +6427,15 @@ Expression *interpret_keys(InterState *istate, Expression *earg, Type *returnTyp
     if (exceptionOrCantInterpret(earg))
         return earg;
     if (earg->op == TOKnull)
-        return new NullExp(earg->loc, returnType);
+        return new (ctfeArena) NullExp(earg->loc, returnType);
     if (earg->op != TOKassocarrayliteral && earg->type->toBasetype()->ty != Taarray)
         return NULL;
     assert(earg->op == TOKassocarrayliteral);
     AssocArrayLiteralExp *aae = (AssocArrayLiteralExp *)earg;
-    ArrayLiteralExp *ae = new ArrayLiteralExp(aae->loc, aae->keys);
+    ArrayLiteralExp *ae = new (ctfeArena) ArrayLiteralExp(aae->loc, aae->keys);
     ae->ownedByCtfe = aae->ownedByCtfe;
     ae->type = returnType;
-    return copyLiteral(ae).copy();
+    return copyLiteral(ae).ctfeCopy();
 }
 
 Expression *interpret_values(InterState *istate, Expression *earg, Type *returnType)
@@ -6441,16 +6447,16 @@ Expression *interpret_values(InterState *istate, Expression *earg, Type *returnT
     if (exceptionOrCantInterpret(earg))
         return earg;
     if (earg->op == TOKnull)
-        return new NullExp(earg->loc, returnType);
+        return new (ctfeArena) NullExp(earg->loc, returnType);
     if (earg->op != TOKassocarrayliteral && earg->type->toBasetype()->ty != Taarray)
         return NULL;
     assert(earg->op == TOKassocarrayliteral);
     AssocArrayLiteralExp *aae = (AssocArrayLiteralExp *)earg;
-    ArrayLiteralExp *ae = new ArrayLiteralExp(aae->loc, aae->values);
+    ArrayLiteralExp *ae = new (ctfeArena) ArrayLiteralExp(aae->loc, aae->values);
     ae->ownedByCtfe = aae->ownedByCtfe;
     ae->type = returnType;
     //printf("result is %s\n", e->toChars());
-    return copyLiteral(ae).copy();
+    return copyLiteral(ae).ctfeCopy();
 }
 
 Expression *interpret_dup(InterState *istate, Expression *earg)
@@ -6462,11 +6468,11 @@ Expression *interpret_dup(InterState *istate, Expression *earg)
     if (exceptionOrCantInterpret(earg))
         return earg;
     if (earg->op == TOKnull)
-        return new NullExp(earg->loc, earg->type);
+        return new (ctfeArena) NullExp(earg->loc, earg->type);
     if (earg->op != TOKassocarrayliteral && earg->type->toBasetype()->ty != Taarray)
         return NULL;
     assert(earg->op == TOKassocarrayliteral);
-    AssocArrayLiteralExp *aae = (AssocArrayLiteralExp *)copyLiteral(earg).copy();
+    AssocArrayLiteralExp *aae = (AssocArrayLiteralExp *)copyLiteral(earg).ctfeCopy();
     for (size_t i = 0; i < aae->keys->dim; i++)
     {
         if (Expression *e = evaluatePostblit(istate, (*aae->keys)[i]))
@@ -6486,7 +6492,7 @@ Expression *interpret_aaApply(InterState *istate, Expression *aa, Expression *de
     if (exceptionOrCantInterpret(aa))
         return aa;
     if (aa->op != TOKassocarrayliteral)
-        return new IntegerExp(deleg->loc, 0, Type::tsize_t);
+        return new (ctfeArena) IntegerExp(deleg->loc, 0, Type::tsize_t);
 
     FuncDeclaration *fd = NULL;
     Expression *pthis = NULL;
@@ -6511,7 +6517,7 @@ Expression *interpret_aaApply(InterState *istate, Expression *aa, Expression *de
 
     AssocArrayLiteralExp *ae = (AssocArrayLiteralExp *)aa;
     if (!ae->keys || ae->keys->dim == 0)
-        return new IntegerExp(deleg->loc, 0, Type::tsize_t);
+        return new (ctfeArena) IntegerExp(deleg->loc, 0, Type::tsize_t);
     Expression *eresult;
 
     for (size_t i = 0; i < ae->keys->dim; ++i)
@@ -6521,7 +6527,7 @@ Expression *interpret_aaApply(InterState *istate, Expression *aa, Expression *de
         if (wantRefValue)
         {
             Type *t = evalue->type;
-            evalue = new IndexExp(deleg->loc, ae, ekey);
+            evalue = new (ctfeArena) IndexExp(deleg->loc, ae, ekey);
             evalue->type = t;
         }
         args[numParams - 1] = evalue;
@@ -6538,6 +6544,69 @@ Expression *interpret_aaApply(InterState *istate, Expression *aa, Expression *de
     return eresult;
 }
 
+/* Iterating over associative arrays for inlined foreach loops. Duplicates
+ * the functionality of _aaIterFirst and _aaIterNext in aaA.d in the runtime:
+ * returns a pointer to the key of the entry at the index held by the
+ * variable idx, sets the variable pvalue to point to its value, and moves
+ * the index past it. Returns null once there are no more entries.  The
+ * bucket array argument is left alone, as literals are indexed directly.
+ */
+Expression *interpret_aaIter(InterState *istate, Loc loc, Expression *aa,
+                             Expression *idx, Expression *pvalue, bool first)
+{
+    aa = interpret(aa, istate);
+    if (exceptionOrCantInterpret(aa))
+        return aa;
+
+    // The index and the value pointer are passed by ref.
+    VarDeclaration *vidx = (idx->op == TOKvar) ? ((VarExp *)idx)->var->isVarDeclaration() : NULL;
+    VarDeclaration *vval = (pvalue->op == TOKvar) ? ((VarExp *)pvalue)->var->isVarDeclaration() : NULL;
+    if (!vidx || !vval)
+    {
+        aa->error("CTFE internal error: cannot foreach %s", aa->toChars());
+        return CTFEExp::cantexp;
+    }
+
+    size_t indx = 0;
+    if (!first)
+    {
+        Expression *eindx = interpret(idx, istate);
+        if (exceptionOrCantInterpret(eindx))
+            return eindx;
+        indx = (size_t)eindx->toInteger();
+    }
+
+    AssocArrayLiteralExp *ae = NULL;
+    if (aa->op == TOKassocarrayliteral)
+        ae = (AssocArrayLiteralExp *)aa;
+    if (!ae || !ae->keys || indx >= ae->keys->dim)
+    {
+        setValue(vidx, new (ctfeArena) IntegerExp(loc, indx, vidx->type));
+        setValue(vval, new (ctfeArena) NullExp(loc, vval->type));
+        return new (ctfeArena) NullExp(loc, Type::tvoidptr);
+    }
+
+    TypeAArray *taa = (TypeAArray *)ae->type->toBasetype();
+    Expression *ekey = (*ae->keys)[indx];
+
+    // Create CTFE pointers &aa[key], and &keys[indx] to the key itself.
+    Expression *e = new (ctfeArena) IndexExp(loc, ae, ekey);
+    e->type = taa->nextOf();
+    e = new (ctfeArena) AddrExp(loc, e);
+    e->type = Type::tvoidptr;
+    setValue(vval, e);
+    setValue(vidx, new (ctfeArena) IntegerExp(loc, indx + 1, vidx->type));
+
+    ArrayLiteralExp *keys = new (ctfeArena) ArrayLiteralExp(loc, ae->keys);
+    keys->type = taa->index->arrayOf();
+    keys->ownedByCtfe = OWNEDctfe;
+    e = new (ctfeArena) IndexExp(loc, keys, new (ctfeArena) IntegerExp(loc, indx, Type::tsize_t));
+    e->type = taa->index;
+    e = new (ctfeArena) AddrExp(loc, e);
+    e->type = Type::tvoidptr;
+    return e;
+}
+
 // Helper function: given a function of type A[] f(...),
 // return A[].
 Type *returnedArrayType(FuncDeclaration *fd)
@@ -6547,6 +6616,148 @@ Type *returnedArrayType(FuncDeclaration *fd)
     return ((TypeFunction *)fd->type)->nextOf();
 }
 
+/* Decode the next dchar from the string literal se or array literal ale
+ * of length len, starting at indx, or ending at indx if rvs.  On return,
+ * indx is past the decoded dchar, or at its start if rvs.
+ * Returns an error message if the string is not valid UTF.
+ */
+static const char *decodeUtf(StringExp *se, ArrayLiteralExp *ale, size_t len,
+        size_t &indx, bool rvs, dchar_t &rawvalue)
+{
+    const char *errmsg = NULL; // Used for reporting decoding errors
+
+    // Buffers for decoding array literals
+    utf8_t utf8buf[4];
+    unsigned short utf16buf[2];
+
+    if (ale)
+    {
+        // If it is an array literal, copy the code points into the buffer
+        size_t buflen = 1; // #code points in the buffer
+        size_t n = 1;   // #code points in this char
+        size_t sz = (size_t)ale->type->nextOf()->size();
+
+        switch (sz)
+        {
+        case 1:
+            if (rvs)
+            {
+                // find the start of the string
+                --indx;
+                buflen = 1;
+                while (indx > 0 && buflen < 4)
+                {
+                    Expression * r = (*ale->elements)[indx];
+                    assert(r->op == TOKint64);
+                    utf8_t x = (utf8_t)(((IntegerExp *)r)->getInteger());
+                    if ((x & 0xC0) != 0x80)
+                        break;
+                    ++buflen;
+                }
+            }
+            else
+                buflen = (indx + 4 > len) ? len - indx : 4;
+            for (size_t i = 0; i < buflen; ++i)
+            {
+                Expression * r = (*ale->elements)[indx + i];
+                assert(r->op == TOKint64);
+                utf8buf[i] = (utf8_t)(((IntegerExp *)r)->getInteger());
+            }
+            n = 0;
+            errmsg = utf_decodeChar(&utf8buf[0], buflen, &n, &rawvalue);
+            break;
+        case 2:
+            if (rvs)
+            {
+                // find the start of the string
+                --indx;
+                buflen = 1;
+                Expression * r = (*ale->elements)[indx];
+                assert(r->op == TOKint64);
+                unsigned short x = (unsigned short)(((IntegerExp *)r)->getInteger());
+                if (indx > 0 && x >= 0xDC00 && x <= 0xDFFF)
+                {
+                    --indx;
+                    ++buflen;
+                }
+            }
+            else
+                buflen = (indx + 2 > len) ? len - indx : 2;
+            for (size_t i=0; i < buflen; ++i)
+            {
+                Expression * r = (*ale->elements)[indx + i];
+                assert(r->op == TOKint64);
+                utf16buf[i] = (unsigned short)(((IntegerExp *)r)->getInteger());
+            }
+            n = 0;
+            errmsg = utf_decodeWchar(&utf16buf[0], buflen, &n, &rawvalue);
+            break;
+        case 4:
+            {
+                if (rvs)
+                    --indx;
+
+                Expression * r = (*ale->elements)[indx];
+                assert(r->op == TOKint64);
+                rawvalue = (dchar_t)((IntegerExp *)r)->getInteger();
+                n = 1;
+            }
+            break;
+        default:
+            assert(0);
+        }
+        if (!rvs)
+            indx += n;
+    }
+    else
+    {
+        // String literals
+        size_t saveindx; // used for reverse iteration
+
+        switch (se->sz)
+        {
+        case 1:
+            if (rvs)
+            {
+                // find the start of the string
+                utf8_t *s = (utf8_t *)se->string;
+                --indx;
+                while (indx > 0 && ((s[indx]&0xC0) == 0x80))
+                    --indx;
+                saveindx = indx;
+            }
+            errmsg = utf_decodeChar((utf8_t *)se->string, se->len, &indx, &rawvalue);
+            if (rvs)
+                indx = saveindx;
+            break;
+        case 2:
+            if (rvs)
+            {
+                // find the start
+                unsigned short *s = (unsigned short *)se->string;
+                --indx;
+                if (s[indx] >= 0xDC00 && s[indx]<= 0xDFFF)
+                    --indx;
+                saveindx = indx;
+            }
+            errmsg = utf_decodeWchar((unsigned short *)se->string, se->len, &indx, &rawvalue);
+            if (rvs)
+                indx = saveindx;
+            break;
+        case 4:
+            if (rvs)
+                --indx;
+            rawvalue = ((unsigned *)(se->string))[indx];
+            if (!rvs)
+                ++indx;
+            break;
+        default:
+            assert(0);
+        }
+    }
+    return errmsg;
+}
+
 /* Decoding UTF strings for foreach loops. Duplicates the functionality of
  * the twelve _aApplyXXn functions in aApply.d in the runtime.
  */
@@ -6574,7 +6785,7 @@ Expression *foreachApplyUtf(InterState *istate, Expression *str, Expression *del
                                      : Type::tsize_t;
     size_t len = (size_t)resolveArrayLength(str);
     if (len == 0)
-        return new IntegerExp(deleg->loc, 0, indexType);
+        return new (ctfeArena) IntegerExp(deleg->loc, 0, indexType);
 
     str = resolveSlice(str);
 
@@ -6594,7 +6805,7 @@ Expression *foreachApplyUtf(InterState *istate, Expression *str, Expression *del
 
     Expression *eresult = NULL;         // ded-store to prevent spurious warning
 
-    // Buffers for encoding; also used for decoding array literals
+    // Buffers for encoding
     utf8_t utf8buf[4];
     unsigned short utf16buf[2];
 
@@ -6604,135 +6815,10 @@ Expression *foreachApplyUtf(InterState *istate, Expression *str, Expression *del
     {
         // Step 1: Decode the next dchar from the string.
 
-        const char *errmsg = NULL; // Used for reporting decoding errors
         dchar_t rawvalue;   // Holds the decoded dchar
         size_t currentIndex = indx; // The index of the decoded character
 
-        if (ale)
-        {
-            // If it is an array literal, copy the code points into the buffer
-            size_t buflen = 1; // #code points in the buffer
-            size_t n = 1;   // #code points in this char
-            size_t sz = (size_t)ale->type->nextOf()->size();
-
-            switch (sz)
-            {
-            case 1:
-                if (rvs)
-                {
-                    // find the start of the string
-                    --indx;
-                    buflen = 1;
-                    while (indx > 0 && buflen < 4)
-                    {
-                        Expression * r = (*ale->elements)[indx];
-                        assert(r->op == TOKint64);
-                        utf8_t x = (utf8_t)(((IntegerExp *)r)->getInteger());
-                        if ((x & 0xC0) != 0x80)
-                            break;
-                        ++buflen;
-                    }
-                }
-                else
-                    buflen = (indx + 4 > len) ? len - indx : 4;
-                for (size_t i = 0; i < buflen; ++i)
-                {
-                    Expression * r = (*ale->elements)[indx + i];
-                    assert(r->op == TOKint64);
-                    utf8buf[i] = (utf8_t)(((IntegerExp *)r)->getInteger());
-                }
-                n = 0;
-                errmsg = utf_decodeChar(&utf8buf[0], buflen, &n, &rawvalue);
-                break;
-            case 2:
-                if (rvs)
-                {
-                    // find the start of the string
-                    --indx;
-                    buflen = 1;
-                    Expression * r = (*ale->elements)[indx];
-                    assert(r->op == TOKint64);
-                    unsigned short x = (unsigned short)(((IntegerExp *)r)->getInteger());
-                    if (indx > 0 && x >= 0xDC00 && x <= 0xDFFF)
-                    {
-                        --indx;
-                        ++buflen;
-                    }
-                }
-                else
-                    buflen = (indx + 2 > len) ? len - indx : 2;
-                for (size_t i=0; i < buflen; ++i)
-                {
-                    Expression * r = (*ale->elements)[indx + i];
-                    assert(r->op == TOKint64);
-                    utf16buf[i] = (unsigned short)(((IntegerExp *)r)->getInteger());
-                }
-                n = 0;
-                errmsg = utf_decodeWchar(&utf16buf[0], buflen, &n, &rawvalue);
-                break;
-            case 4:
-                {
-                    if (rvs)
-                        --indx;
-
-                    Expression * r = (*ale->elements)[indx];
-                    assert(r->op == TOKint64);
-                    rawvalue = (dchar_t)((IntegerExp *)r)->getInteger();
-                    n = 1;
-                }
-                break;
-            default:
-                assert(0);
-            }
-            if (!rvs)
-                indx += n;
-        }
-        else
-        {
-            // String literals
-            size_t saveindx; // used for reverse iteration
-
-            switch (se->sz)
-            {
-            case 1:
-                if (rvs)
-                {
-                    // find the start of the string
-                    utf8_t *s = (utf8_t *)se->string;
-                    --indx;
-                    while (indx > 0 && ((s[indx]&0xC0) == 0x80))
-                        --indx;
-                    saveindx = indx;
-                }
-                errmsg = utf_decodeChar((utf8_t *)se->string, se->len, &indx, &rawvalue);
-                if (rvs)
-                    indx = saveindx;
-                break;
-            case 2:
-                if (rvs)
-                {
-                    // find the start
-                    unsigned short *s = (unsigned short *)se->string;
-                    --indx;
-                    if (s[indx] >= 0xDC00 && s[indx]<= 0xDFFF)
-                        --indx;
-                    saveindx = indx;
-                }
-                errmsg = utf_decodeWchar((unsigned short *)se->string, se->len, &indx, &rawvalue);
-                if (rvs)
-                    indx = saveindx;
-                break;
-            case 4:
-                if (rvs)
-                    --indx;
-                rawvalue = ((unsigned *)(se->string))[indx];
-                if (!rvs)
-                    ++indx;
-                break;
-            default:
-                assert(0);
-            }
-        }
+        const char *errmsg = decodeUtf(se, ale, len, indx, rvs, rawvalue);
         if (errmsg)
         {
             deleg->error("%s", errmsg);
@@ -6764,7 +6850,7 @@ Expression *foreachApplyUtf(InterState *istate, Expression *str, Expression *del
 
         // The index only needs to be set once
         if (numParams == 2)
-            args[0] = new IntegerExp(deleg->loc, currentIndex, indexType);
+            args[0] = new (ctfeArena) IntegerExp(deleg->loc, currentIndex, indexType);
 
         Expression *val = NULL;
 
@@ -6785,7 +6871,7 @@ Expression *foreachApplyUtf(InterState *istate, Expression *str, Expression *del
                 default:
                     assert(0);
             }
-            val = new IntegerExp(str->loc, codepoint, charType);
+            val = new (ctfeArena) IntegerExp(str->loc, codepoint, charType);
 
             args[numParams - 1] = val;
 
@@ -6800,6 +6886,62 @@ Expression *foreachApplyUtf(InterState *istate, Expression *str, Expression *del
     return eresult;
 }
 
+/* Decoding UTF strings for inlined foreach loops. Duplicates the
+ * functionality of the _aApplyDecodeX and _aApplyRDecodeX functions in
+ * aApply.d and aApplyR.d in the runtime: decodes the dchar in str at the
+ * index held by the variable idx, and moves the index past it.
+ */
+Expression *foreachDecodeUtf(InterState *istate, Loc loc, Expression *str, Expression *idx, bool rvs)
+{
+    str = interpret(str, istate);
+    if (exceptionOrCantInterpret(str))
+        return str;
+
+    // The index is passed by ref.
+    VarDeclaration *v = (idx->op == TOKvar) ? ((VarExp *)idx)->var->isVarDeclaration() : NULL;
+    if (!v)
+    {
+        idx->error("CTFE internal error: cannot decode %s", str->toChars());
+        return CTFEExp::cantexp;
+    }
+    Expression *eindx = interpret(idx, istate);
+    if (exceptionOrCantInterpret(eindx))
+        return eindx;
+
+    size_t indx = (size_t)eindx->toInteger();
+    size_t len = (size_t)resolveArrayLength(str);
+    if (rvs ? indx == 0 || indx > len : indx >= len)
+    {
+        error(loc, "string index %llu is out of bounds [0 .. %llu]", (ulonglong)indx, (ulonglong)len);
+        return CTFEExp::cantexp;
+    }
+
+    str = resolveSlice(str);
+
+    StringExp *se = NULL;
+    ArrayLiteralExp *ale = NULL;
+    if (str->op == TOKstring)
+        se = (StringExp *) str;
+    else if (str->op == TOKarrayliteral)
+        ale = (ArrayLiteralExp *)str;
+    else
+    {
+        str->error("CTFE internal error: cannot foreach %s", str->toChars());
+        return CTFEExp::cantexp;
+    }
+
+    dchar_t rawvalue;
+    const char *errmsg = decodeUtf(se, ale, len, indx, rvs, rawvalue);
+    if (errmsg)
+    {
+        error(loc, "%s", errmsg);
+        return CTFEExp::cantexp;
+    }
+
+    setValue(v, new (ctfeArena) IntegerExp(loc, indx, v->type));
+    return new (ctfeArena) IntegerExp(loc, rawvalue, Type::tdchar);
+}
+
 /* If this is a built-in function, return the interpreted result,
  * Otherwise, return NULL.
  */
@@ -6843,6 +6985,10 @@ Expression *evaluateIfBuiltin(InterState *istate, Loc loc,
                 return interpret_aaApply(istate, firstarg, (Expression *)(arguments->data[2]));
             if (nargs == 3 && !strcmp(id, "_aaApply2"))
                 return interpret_aaApply(istate, firstarg, (Expression *)(arguments->data[2]));
+            if (nargs == 4 && !strcmp(id, "_aaIterFirst"))
+                return interpret_aaIter(istate, loc, firstarg, (*arguments)[2], (*arguments)[3], true);
+            if (nargs == 4 && !strcmp(id, "_aaIterNext"))
+                return interpret_aaIter(istate, loc, firstarg, (*arguments)[2], (*arguments)[3], false);
             if (nargs == 1 && !strcmp(id, "keys") && !strcmp(fd->toParent2()->ident->toChars(), "object"))
                 return interpret_keys(istate, firstarg, firstAAtype->index->arrayOf());
             if (nargs == 1 && !strcmp(id, "values") && !strcmp(fd->toParent2()->ident->toChars(), "object"))
@@ -6901,6 +7047,14 @@ Expression *evaluateIfBuiltin(InterState *istate, Loc loc,
                 return foreachApplyUtf(istate, str, (*arguments)[1], rvs);
             }
         }
+        if (nargs == 2 && (idlen == 14 || idlen == 15) &&
+            !strncmp(id, "_aApply", 7) && !strncmp(id + idlen - 7, "Decode", 6))
+        {
+            // Functions from aApply.d and aApplyR.d in the runtime, used by
+            // foreach loops that decode inline.
+            bool rvs = (idlen == 15);   // true if foreach_reverse
+            return foreachDecodeUtf(istate, loc, (*arguments)[0], (*arguments)[1], rvs);
+        }
     }
     return e;
 }
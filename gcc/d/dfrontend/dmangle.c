@@ -15,6 +15,7 @@
 #include <assert.h>
 
 #include "root.h"
+#include "aav.h"
 
 #include "init.h"
 #include "declaration.h"
@@ -138,12 +139,88 @@ class Mangler : public Visitor
 {
 public:
     OutBuffer *buf;
+    bool backref;       // compress repeated types and identifiers
+    AA *types;          // Type* => offset + 1 of first occurrence in buf
+    AA *idents;         // Identifier* => offset + 1 of first occurrence in buf
+    size_t nidents;     // number of identifiers mangled so far
 
-    Mangler(OutBuffer *buf)
+    Mangler(OutBuffer *buf, bool backref = false)
     {
         this->buf = buf;
+        this->backref = backref;
+        this->types = NULL;
+        this->idents = NULL;
+        this->nidents = 0;
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+
+    /**************************************************
+     * Back references
+     *
+     * With -fmangle-backrefs, a type or identifier that has already been
+     * written to the symbol is replaced by 'Q' followed by the distance
+     * back to its first occurrence, in base 26 with upper case letters for
+     * all digits except the last, which is lower case.  The demangler tells
+     * a type from an identifier by looking at the referenced position.
+     */
+
+    void writeBackRef(size_t pos)
+    {
+        buf->writeByte('Q');
+        const size_t base = 26;
+        size_t mul = 1;
+        while (pos >= mul * base)
+            mul *= base;
+        while (mul >= base)
+        {
+            unsigned char dig = (unsigned char)(pos / mul);
+            buf->writeByte('A' + dig);
+            pos -= dig * mul;
+            mul /= base;
+        }
+        buf->writeByte('a' + (unsigned char)pos);
+    }
+
+    /* Returns true if a back reference to a previous occurrence of t was
+     * written, otherwise remember where t is about to be mangled.
+     * Basic types are never replaced, they are shorter than a reference.
+     */
+    bool backrefType(Type *t)
+    {
+        if (!backref || t->isTypeBasic())
+            return false;
+        size_t *p = (size_t *)dmd_aaGet(&types, (void *)t);
+        if (*p)
+        {
+            writeBackRef(buf->offset - (*p - 1));
+            return true;
+        }
+        *p = buf->offset + 1;
+        return false;
+    }
+
+    // ditto, for identifiers
+    bool backrefIdentifier(Identifier *id)
+    {
+        if (!backref)
+            return false;
+        size_t *p = (size_t *)dmd_aaGet(&idents, (void *)id);
+        if (*p)
+        {
+            writeBackRef(buf->offset - (*p - 1));
+            return true;
+        }
+        *p = buf->offset + 1;
+        return false;
+    }
+
+    void mangleIdentifier(Identifier *id, Dsymbol *s)
+    {
+        nidents++;
+        if (!backrefIdentifier(id))
+            toBuffer(id->toChars(), s);
+    }
 
     ////////////////////////////////////////////////////////////////////////////
 
@@ -157,7 +234,8 @@ public:
         {
             MODtoDecoBuffer(buf, t->mod);
         }
-        t->accept(this);
+        if (!backrefType(t))
+            t->accept(this);
     }
 
     void visit(Type *t)
@@ -327,8 +405,7 @@ public:
         mangleParent(sthis);
 
         assert(sthis->ident);
-        const char *id = sthis->ident->toChars();
-        toBuffer(id, sthis);
+        mangleIdentifier(sthis->ident, sthis);
 
         if (FuncDeclaration *fd = sthis->isFuncDeclaration())
         {
@@ -336,7 +413,10 @@ public:
         }
         else if (sthis->type->deco)
         {
-            buf->writestring(sthis->type->deco);
+            if (backref)
+                visitWithMask(sthis->type, 0);
+            else
+                buf->writestring(sthis->type->deco);
         }
         else
             assert(0);
@@ -354,10 +434,14 @@ public:
         {
             mangleParent(p);
 
-            if (p->getIdent())
+            TemplateInstance *ti = p->isTemplateInstance();
+            if (backref && ti && !ti->isTemplateMixin())
+            {
+                mangleTemplateInstance(ti);
+            }
+            else if (p->getIdent())
             {
-                const char *id = p->ident->toChars();
-                toBuffer(id, s);
+                mangleIdentifier(p->ident, s);
 
                 if (FuncDeclaration *f = p->isFuncDeclaration())
                     mangleFunc(f, true);
@@ -381,7 +465,10 @@ public:
         }
         else if (fd->type->deco)
         {
-            buf->writestring(fd->type->deco);
+            if (backref)
+                visitWithMask(fd->type, 0);
+            else
+                buf->writestring(fd->type->deco);
         }
         else
         {
@@ -612,6 +699,12 @@ public:
         else
             mangleParent(ti);
 
+        if (backref && ti->tempdecl && !ti->isTemplateMixin())
+        {
+            mangleTemplateInstance(ti);
+            return;
+        }
+
         ti->getIdent();
         const char *id = ti->ident ? ti->ident->toChars() : ti->toChars();
         toBuffer(id, ti);
@@ -630,10 +723,115 @@ public:
 
         mangleParent(s);
 
-        const char *id = s->ident ? s->ident->toChars() : s->toChars();
-        toBuffer(id, s);
+        if (s->ident)
+            mangleIdentifier(s->ident, s);
+        else
+            toBuffer(s->toChars(), s);
+    }
+
+    /******************************************************************************
+     * Mangle a template instance in place, rather than writing the length
+     * prefixed identifier built by TemplateInstance::genIdent(), so that the
+     * template arguments can refer back to types and identifiers already in
+     * the symbol.  The arguments are encoded the same way genIdent() does,
+     * which has already diagnosed any that are invalid.
+     *
+     *      __T LName TemplateArgs Z
+     */
+    void mangleTemplateInstance(TemplateInstance *ti)
+    {
+        TemplateDeclaration *tempdecl = ti->tempdecl->isTemplateDeclaration();
+        assert(tempdecl);
+
+        // Use "__U" for the symbols declared inside template constraint.
+        buf->writestring(ti->members ? "__T" : "__U");
+        mangleIdentifier(tempdecl->ident, tempdecl);
 
-        //printf("Dsymbol::mangle() %s = %s\n", s->toChars(), id);
+        Objects *args = ti->tiargs;
+        size_t nparams = tempdecl->parameters->dim - (tempdecl->isVariadic() ? 1 : 0);
+        for (size_t i = 0; i < args->dim; i++)
+        {
+            RootObject *o = (*args)[i];
+            Type *ta = isType(o);
+            Expression *ea = isExpression(o);
+            Dsymbol *sa = isDsymbol(o);
+            Tuple *va = isTuple(o);
+            if (i < nparams && (*tempdecl->parameters)[i]->specialization())
+                buf->writeByte('H');     // Bugzilla 6574
+            if (ta)
+            {
+                buf->writeByte('T');
+                if (ta->deco)
+                    visitWithMask(ta, 0);
+            }
+            else if (ea)
+            {
+                const bool keepLvalue = true;
+                ea = ea->optimize(WANTvalue, keepLvalue);
+                if (ea->op == TOKvar)
+                {
+                    sa = ((VarExp *)ea)->var;
+                    goto Lsa;
+                }
+                if (ea->op == TOKthis)
+                {
+                    sa = ((ThisExp *)ea)->var;
+                    goto Lsa;
+                }
+                if (ea->op == TOKfunction)
+                {
+                    if (((FuncExp *)ea)->td)
+                        sa = ((FuncExp *)ea)->td;
+                    else
+                        sa = ((FuncExp *)ea)->fd;
+                    goto Lsa;
+                }
+                buf->writeByte('V');
+                if (ea->op == TOKtuple)
+                    continue;
+                unsigned olderr = global.errors;
+                ea = ea->ctfeInterpret();
+                if (ea->op == TOKerror || olderr != global.errors)
+                    continue;
+
+                visitWithMask(ea->type, 0);
+                ea->accept(this);
+            }
+            else if (sa)
+            {
+              Lsa:
+                buf->writeByte('S');
+                sa = sa->toAlias();
+                Declaration *d = sa->isDeclaration();
+                if (d && (!d->type || !d->type->deco))
+                    continue;
+
+                /* D symbols and qualified names are written as is.  Anything
+                 * else, such as an extern(C) name or _Dmain, mangles no
+                 * identifiers and keeps the length prefix so the demangler
+                 * can find where it ends.
+                 */
+                size_t start = buf->offset;
+                size_t nids = nidents;
+                sa->accept(this);
+                if (nidents == nids)
+                {
+                    size_t len = buf->offset - start;
+                    char lenbuf[sizeof(len) * 3 + 1];
+                    int n = sprintf(lenbuf, "%llu", (ulonglong)len);
+                    buf->insert(start, lenbuf, n);
+                }
+            }
+            else if (va)
+            {
+                assert(i + 1 == args->dim);         // must be last one
+                args = &va->objects;
+                i = -(size_t)1;
+            }
+            else
+                assert(0);
+        }
+        buf->writeByte('Z');
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -871,7 +1069,7 @@ const char *mangleExact(FuncDeclaration *fd)
     if (!fd->mangleString)
     {
         OutBuffer buf;
-        Mangler v(&buf);
+        Mangler v(&buf, global.params.mangleBackrefs);
         v.mangleExact(fd);
         fd->mangleString = buf.extractString();
     }
@@ -892,6 +1090,6 @@ void mangleToBuffer(Expression *e, OutBuffer *buf)
 
 void mangleToBuffer(Dsymbol *s, OutBuffer *buf)
 {
-    Mangler v(buf);
+    Mangler v(buf, global.params.mangleBackrefs);
     s->accept(&v);
 }
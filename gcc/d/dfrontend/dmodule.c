@@ -11,6 +11,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <assert.h>
 
 #include "mars.h"
@@ -39,6 +40,8 @@ AggregateDeclaration *Module::moduleinfo;
 Module *Module::rootModule;
 DsymbolTable *Module::modules;
 Modules Module::amodules;
+unsigned Module::importGeneration;
+unsigned Module::sccGeneration;
 
 Dsymbols Module::deferred;  // deferred Dsymbol's needing semantic() run on them
 Dsymbols Module::deferred2; // deferred Dsymbol's needing semantic2() run on them
@@ -66,8 +69,10 @@ Module::Module(const char *filename, Identifier *ident, int doDocComment, int do
     isDocFile = 0;
     isPackageFile = false;
     needmoduleinfo = 0;
-    selfimports = 0;
-    rootimports = 0;
+    hasctordtor = false;
+    selfimports = false;
+    rootimports = false;
+    sccIndex = 0;
     insearch = 0;
     searchCacheIdent = NULL;
     searchCacheSymbol = NULL;
@@ -535,7 +540,7 @@ Module *Module::parse()
         p.nextToken();
         members = p.parseModule();
         md = p.md;
-        numlines = p.scanloc.linnum;
+        numlines = p.linnum;
         if (p.errors)
             ++global.errors;
     }
@@ -1131,52 +1136,132 @@ int Module::imports(Module *m)
 }
 
 /*************************************
- * Return true if module imports itself.
+ * Record that this module imports m, updating the reverse edges
+ * and the set of modules that transitively import a root module.
+ * A module reaches a root module if any of its imports is a root
+ * module or reaches one, so each new edge only needs to propagate
+ * backwards through importedBy, visiting every module at most once.
  */
 
-bool Module::selfImports()
+void Module::addImport(Module *m)
 {
-    //printf("Module::selfImports() %s\n", toChars());
-    if (selfimports == 0)
-    {
-        for (size_t i = 0; i < amodules.dim; i++)
-            amodules[i]->insearch = 0;
+    aimports.push(m);
+    m->importedBy.push(this);
+    importGeneration++;
 
-        selfimports = imports(this) + 1;
+    if (rootimports || !(m->isRoot() || m->rootimports))
+        return;
 
-        for (size_t i = 0; i < amodules.dim; i++)
-            amodules[i]->insearch = 0;
+    Modules worklist;
+    rootimports = true;
+    worklist.push(this);
+    while (worklist.dim)
+    {
+        Module *mi = worklist.pop();
+        for (size_t i = 0; i < mi->importedBy.dim; i++)
+        {
+            Module *importer = mi->importedBy[i];
+            if (!importer->rootimports)
+            {
+                importer->rootimports = true;
+                worklist.push(importer);
+            }
+        }
     }
-    return selfimports == 2;
 }
 
 /*************************************
- * Return true if module imports root module.
+ * Compute the strongly connected components of the import graph
+ * of all modules, using Pearce's variant of Tarjan's algorithm so
+ * that sccIndex doubles as the DFS index. Modules that share a
+ * component with another module, or that import themselves
+ * directly, are part of an import cycle.
  */
 
-bool Module::rootImports()
+struct ImportSCCs
 {
-    //printf("Module::rootImports() %s\n", toChars());
-    if (rootimports == 0)
+    unsigned index;     // next DFS index, starting at 1 as 0 means unvisited
+    unsigned component; // next component number, counting down
+    Modules stack;
+
+    void visit(Module *v)
     {
-        for (size_t i = 0; i < amodules.dim; i++)
-            amodules[i]->insearch = 0;
+        bool root = true;
+        v->sccIndex = index++;
 
-        rootimports = 1;
-        for (size_t i = 0; i < amodules.dim; ++i)
+        for (size_t i = 0; i < v->aimports.dim; i++)
         {
-            Module *m = amodules[i];
-            if (m->isRoot() && imports(m))
+            Module *w = v->aimports[i];
+            if (w == v)
+                v->selfimports = true;
+            if (w->sccIndex == 0)
+                visit(w);
+            if (w->sccIndex < v->sccIndex)
             {
-                rootimports = 2;
-                break;
+                v->sccIndex = w->sccIndex;
+                root = false;
             }
         }
 
-        for (size_t i = 0; i < amodules.dim; i++)
-            amodules[i]->insearch = 0;
+        if (!root)
+        {
+            stack.push(v);
+            return;
+        }
+
+        index--;
+        while (stack.dim && v->sccIndex <= stack[stack.dim - 1]->sccIndex)
+        {
+            Module *w = stack.pop();
+            w->sccIndex = component;
+            w->selfimports = true;
+            v->selfimports = true;
+            index--;
+        }
+        v->sccIndex = component--;
     }
-    return rootimports == 2;
+};
+
+void Module::computeImportSCCs()
+{
+    for (size_t i = 0; i < amodules.dim; i++)
+    {
+        amodules[i]->sccIndex = 0;
+        amodules[i]->selfimports = false;
+    }
+
+    ImportSCCs sccs;
+    sccs.index = 1;
+    sccs.component = UINT_MAX;
+    for (size_t i = 0; i < amodules.dim; i++)
+    {
+        if (amodules[i]->sccIndex == 0)
+            sccs.visit(amodules[i]);
+    }
+
+    sccGeneration = importGeneration;
+}
+
+/*************************************
+ * Return true if module imports itself.
+ */
+
+bool Module::selfImports()
+{
+    //printf("Module::selfImports() %s\n", toChars());
+    if (sccGeneration != importGeneration)
+        computeImportSCCs();
+    return selfimports;
+}
+
+/*************************************
+ * Return true if module imports root module.
+ */
+
+bool Module::rootImports()
+{
+    //printf("Module::rootImports() %s\n", toChars());
+    return rootimports;
 }
 
 bool Module::isCoreModule(Identifier *ident)
@@ -734,10 +734,18 @@ void Scope::deprecation10378(Loc loc, Dsymbol *sold, Dsymbol *snew)
 
 Dsymbol *Scope::search_correct(Identifier *ident)
 {
-    if (global.gag)
-        return NULL;            // don't do it for speculative compiles; too time consuming
+    // Don't do it for speculative compiles, the suggestion would never be seen.
+    if (global.gag && !global.params.showGaggedErrors)
+        return NULL;
 
-    return (Dsymbol *)speller(ident->toChars(), &scope_search_fp, this, idchars);
+    Spellings sp(ident->toChars());
+    for (Scope *sc = this; sc; sc = sc->enclosing)
+    {
+        if (sc->scopesym && sc->scopesym->isScopeDsymbol())
+            sc->scopesym->isScopeDsymbol()->spellings(&sp);
+    }
+    return (Dsymbol *)spellerWords(sp.seed, &scope_search_fp, this, idchars,
+                                   sp.words.tdata(), sp.words.dim);
 }
 
 /************************************
@@ -279,12 +279,12 @@ const char *Dsymbol::toPrettyChars(bool QualifyTypes)
 
 Loc& Dsymbol::getLoc()
 {
-    if (!loc.filename)  // avoid bug 5861.
+    if (!loc.filename())  // avoid bug 5861.
     {
         Module *m = getModule();
 
         if (m && m->srcfile)
-            loc.filename = m->srcfile->toChars();
+            loc = Loc(m->srcfile->toChars(), loc.linnum(), loc.charnum());
     }
     return loc;
 }
@@ -503,10 +503,18 @@ void *symbol_search_fp(void *arg, const char *seed, int *cost)
 
 Dsymbol *Dsymbol::search_correct(Identifier *ident)
 {
-    if (global.gag)
-        return NULL;            // don't do it for speculative compiles; too time consuming
+    // Don't do it for speculative compiles, the suggestion would never be seen.
+    if (global.gag && !global.params.showGaggedErrors)
+        return NULL;
+
+    ScopeDsymbol *sds = isScopeDsymbol();
+    if (!sds)
+        return NULL;
 
-    return (Dsymbol *)speller(ident->toChars(), &symbol_search_fp, (void *)this, idchars);
+    Spellings sp(ident->toChars());
+    sds->spellings(&sp);
+    return (Dsymbol *)spellerWords(sp.seed, &symbol_search_fp, (void *)this, idchars,
+                                   sp.words.tdata(), sp.words.dim);
 }
 
 /***************************************
@@ -690,6 +698,8 @@ void Dsymbol::addMember(Scope *sc, ScopeDsymbol *sds)
                 sds->multiplyDefined(Loc(), this, s2);
                 errors = true;
             }
+            else
+                overloadSetGrown(s2, this);
         }
         if (sds->isAggregateDeclaration() || sds->isEnumDeclaration())
         {
@@ -1263,7 +1273,7 @@ void ScopeDsymbol::multiplyDefined(Loc loc, Dsymbol *s1, Dsymbol *s2)
     printf("s1 = %p, '%s' kind = '%s', parent = %s\n", s1, s1->toChars(), s1->kind(), s1->parent ? s1->parent->toChars() : "");
     printf("s2 = %p, '%s' kind = '%s', parent = %s\n", s2, s2->toChars(), s2->kind(), s2->parent ? s2->parent->toChars() : "");
 #endif
-    if (loc.filename)
+    if (loc.filename())
     {   ::error(loc, "%s at %s conflicts with %s at %s",
             s1->toPrettyChars(),
             s1->locToChars(),
@@ -1440,6 +1450,59 @@ FuncDeclaration *ScopeDsymbol::findGetMembers()
 }
 
 
+/*******************************************
+ * Collect the names that a search of this scope could find and that
+ * might be misspellings of sp->seed, following the same imports and
+ * base classes as search() does with the given flags.
+ * The names are only candidates, and still need to be looked up.
+ */
+
+void ScopeDsymbol::spellings(Spellings *sp, int flags)
+{
+    ScopeDsymbol **psds = (ScopeDsymbol **)dmd_aaGet(&sp->visited, (void *)this);
+    if (*psds)
+        return;
+    *psds = this;
+
+    if (symtab)
+        symtab->spellings(sp);
+
+    if (ClassDeclaration *cd = isClassDeclaration())
+    {
+        for (size_t i = 0; i < cd->baseclasses->dim; i++)
+        {
+            BaseClass *b = (*cd->baseclasses)[i];
+            if (b->sym)
+                b->sym->spellings(sp, flags);
+        }
+    }
+
+    if (WithScopeSymbol *ws = isWithScopeSymbol())
+    {
+        Expression *e = ws->withstate->exp;
+        Dsymbol *s = NULL;
+        if (e->op == TOKscope)
+            s = ((ScopeExp *)e)->sds;
+        else if (e->type)
+            s = e->type->toBasetype()->toDsymbol(NULL);
+        if (s && s->isScopeDsymbol())
+            s->isScopeDsymbol()->spellings(sp, flags);
+    }
+
+    if (importedScopes)
+    {
+        for (size_t i = 0; i < importedScopes->dim; i++)
+        {
+            if ((flags & IgnorePrivateImports) && prots[i] == PROTprivate)
+                continue;
+
+            Dsymbol *ss = (*importedScopes)[i];
+            if (ScopeDsymbol *sds = ss->isScopeDsymbol())
+                sds->spellings(sp, ss->isModule() ? IgnorePrivateImports : flags);
+        }
+    }
+}
+
 /****************************** WithScopeSymbol ******************************/
 
 WithScopeSymbol::WithScopeSymbol(WithStatement *withstate)
@@ -1701,6 +1764,7 @@ Dsymbol *ArrayScopeSymbol::search(Loc loc, Identifier *ident, int flags)
 DsymbolTable::DsymbolTable()
 {
     tab = NULL;
+    spellindex = NULL;
 }
 
 Dsymbol *DsymbolTable::lookup(Identifier const * const ident)
@@ -1717,6 +1781,8 @@ Dsymbol *DsymbolTable::insert(Dsymbol *s)
     if (*ps)
         return NULL;            // already in table
     *ps = s;
+    if (spellindex)
+        spellindex->add(ident->toChars(), strlen(ident->toChars()));
     return s;
 }
 
@@ -1727,6 +1793,11 @@ Dsymbol *DsymbolTable::insert(Identifier const * const ident, Dsymbol *s)
     if (*ps)
         return NULL;            // already in table
     *ps = s;
+    if (spellindex)
+    {
+        const char *p = const_cast<Identifier *>(ident)->toChars();
+        spellindex->add(p, strlen(p));
+    }
     return s;
 }
 
@@ -1734,10 +1805,50 @@ Dsymbol *DsymbolTable::update(Dsymbol *s)
 {
     Identifier *ident = s->ident;
     Dsymbol **ps = (Dsymbol **)dmd_aaGet(&tab, (void *)ident);
+    if (!*ps && spellindex)
+        spellindex->add(ident->toChars(), strlen(ident->toChars()));
     *ps = s;
     return s;
 }
 
+static int addSpelling(void *param, Key key, Value)
+{
+    const char *p = ((Identifier *)key)->toChars();
+    ((SpellIndex *)param)->add(p, strlen(p));
+    return 0;
+}
+
+static void addSpellingCandidate(void *param, const char *word)
+{
+    Spellings *sp = (Spellings *)param;
+    const char **pw = (const char **)dmd_aaGet(&sp->seen, (void *)word);
+    if (*pw)
+        return;
+    *pw = word;
+    sp->words.push(word);
+}
+
+void DsymbolTable::spellings(Spellings *sp)
+{
+    if (!spellindex)
+    {
+        spellindex = new SpellIndex();
+        spellindex->_init(dmd_aaLen(tab));
+        dmd_aaApply(tab, &addSpelling, spellindex);
+    }
+    spellindex->lookup(sp->seed, sp->seedlen, &addSpellingCandidate, sp);
+}
+
+/****************************** Spellings ******************************/
+
+Spellings::Spellings(const char *seed)
+{
+    this->seed = seed;
+    this->seedlen = strlen(seed);
+    this->visited = NULL;
+    this->seen = NULL;
+}
+
 /****************************** Prot ******************************/
 
 Prot::Prot()
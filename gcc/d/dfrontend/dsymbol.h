@@ -75,6 +75,7 @@ class Expression;
 class DeleteDeclaration;
 class OverloadSet;
 struct AA;
+struct SpellIndex;
 #ifdef IN_GCC
 typedef union tree_node Symbol;
 #else
@@ -155,6 +156,18 @@ enum
 
 typedef int (*Dsymbol_apply_ft_t)(Dsymbol *, void *);
 
+// Identifiers that might be misspellings of seed, collected by ScopeDsymbol::spellings()
+struct Spellings
+{
+    const char *seed;
+    size_t seedlen;
+    AA *visited;                // scopes already looked in
+    AA *seen;                   // words already collected
+    Strings words;              // candidate spellings
+
+    Spellings(const char *seed);
+};
+
 class Dsymbol : public RootObject
 {
 public:
@@ -323,6 +336,7 @@ public:
     virtual Dsymbol *symtabInsert(Dsymbol *s);
     virtual Dsymbol *symtabLookup(Dsymbol *s, Identifier *id);
     bool hasStaticCtorOrDtor();
+    void spellings(Spellings *sp, int flags = IgnoreNone);
 
     static size_t dim(Dsymbols *members);
     static Dsymbol *getNth(Dsymbols *members, size_t nth, size_t *pn = NULL);
@@ -400,6 +414,7 @@ class DsymbolTable : public RootObject
 {
 public:
     AA *tab;
+    SpellIndex *spellindex;     // built on demand by spellings()
 
     DsymbolTable();
 
@@ -412,6 +427,9 @@ public:
     // Look for Dsymbol in table. If there, return it. If not, insert s and return that.
     Dsymbol *update(Dsymbol *s);
     Dsymbol *insert(Identifier const * const ident, Dsymbol *s);     // when ident and s are not the same
+
+    // Add identifiers in table that might be misspellings of sp->seed to sp.
+    void spellings(Spellings *sp);
 };
 
 #endif /* DMD_DSYMBOL_H */
@@ -748,6 +748,17 @@ bool TemplateDeclaration::overloadInsert(Dsymbol *s)
     return true;
 }
 
+/*************************************************
+ * Whether a template is rejected as a recursive instantiation depends on
+ * the scope it is being matched from, so an overload resolution made
+ * while such checks are active can only be reused under the same ones.
+ * Each region that threads a TemplatePrevious gets a new frame number,
+ * and recursionFrame is that of the innermost one, or 0 outside any.
+ */
+
+static unsigned recursionFrames = 0;
+static unsigned recursionFrame = 0;
+
 /****************************
  * Check to see if constraint is satisfied.
  */
@@ -792,6 +803,9 @@ bool TemplateDeclaration::evaluateConstraint(
     pr.dedargs = dedargs;
     previous = &pr;                 // add this to threaded list
 
+    unsigned frame = recursionFrame;
+    recursionFrame = ++recursionFrames;
+
     unsigned int nerrors = global.errors;
 
     Scope *scx = paramscope->push(ti);
@@ -855,6 +869,7 @@ bool TemplateDeclaration::evaluateConstraint(
     ti->symtab = NULL;
     scx = scx->pop();
     previous = pr.prev;             // unlink from threaded list
+    recursionFrame = frame;
     if (errors)
         return false;
     return result;
@@ -2233,6 +2248,276 @@ bool TemplateDeclaration::isOverloadable()
     return true;
 }
 
+/*************************************************
+ * Cache of resolved calls, so that repeatedly calling the same overload
+ * set with the same argument types doesn't redo overload matching and
+ * template argument deduction for every candidate.
+ * Entries are chained off the root of the overload set, and are stale
+ * once the generation of the overload sets reachable from it changes.
+ */
+
+struct FuncResolveEntry
+{
+    FuncResolveEntry *next;
+    size_t generation;          // overloadSetGeneration() when entry was added
+
+    // key
+    unsigned frame;             // recursionFrame the call was resolved in
+    const char *tthis;          // deco of 'this' type, NULL if none
+    Objects *tiargs;            // explicitly given template arguments
+    size_t nargs;
+    const char **argtypes;      // decos of the function argument types
+    bool *arglvalues;           // lvalue-ness of the function arguments
+
+    // result
+    MATCH last;
+    FuncDeclaration *lastf;     // best match
+    TemplateDeclaration *td_best; // if !NULL, the template lastf was instantiated from
+    Objects *tdargs;            // deduced template arguments of td_best
+    size_t ov_index;            // index of lastf in overloads of td_best
+};
+
+static AA *funcResolveCache = NULL;
+
+/*************************************************
+ * Number of times each symbol has headed, or been added to, an
+ * overload set that gained a member.
+ */
+
+static AA *overloadGenerations = NULL;
+
+/*************************************************
+ * Called when member is inserted into the overload set headed by head.
+ * Both are bumped so that the change is seen by walks that start from
+ * head, and by walks that start further down the chain and only reach
+ * the new member at its end.
+ */
+
+void overloadSetGrown(Dsymbol *head, Dsymbol *member)
+{
+    size_t *pgen = (size_t *)dmd_aaGet(&overloadGenerations, (void *)head);
+    (*pgen)++;
+    pgen = (size_t *)dmd_aaGet(&overloadGenerations, (void *)member);
+    (*pgen)++;
+}
+
+/*************************************************
+ * Walk the overload sets reachable from fstart the same way overloadApply
+ * does, and return the sum of the generations of the symbols visited.
+ * Sets only ever grow, so the sum changes whenever any of them does.
+ */
+
+static size_t overloadSetGeneration(Dsymbol *fstart)
+{
+    size_t generation = 0;
+    Dsymbol *d = fstart;
+    while (d)
+    {
+        generation += (size_t)dmd_aaGetRvalue(overloadGenerations, (void *)d);
+
+        if (OverDeclaration *od = d->isOverDeclaration())
+        {
+            if (od->hasOverloads)
+                generation += overloadSetGeneration(od->aliassym);
+            d = od->overnext;
+        }
+        else if (FuncAliasDeclaration *fa = d->isFuncAliasDeclaration())
+        {
+            if (fa->hasOverloads)
+                generation += overloadSetGeneration(fa->funcalias);
+            d = fa->overnext;
+        }
+        else if (AliasDeclaration *ad = d->isAliasDeclaration())
+        {
+            Dsymbol *next = ad->toAlias();
+            if (next == ad || next == fstart)
+                break;
+            d = next;
+        }
+        else if (TemplateDeclaration *td = d->isTemplateDeclaration())
+            d = td->overnext;
+        else if (FuncDeclaration *fd = d->isFuncDeclaration())
+            d = fd->overnext;
+        else
+            break;
+    }
+    return generation;
+}
+
+/*************************************************
+ * Returns true if the resolution of a call with the given context and
+ * arguments only depends on their types, and can be cached.
+ */
+
+static bool isResolveCacheable(Scope *sc, Type *tthis, Objects *tiargs, Expressions *fargs)
+{
+    // Type::aliasthisOf and friends resolve without a scope.
+    if (!sc)
+        return false;
+    if (tthis && !tthis->deco)
+        return false;
+
+    if (tiargs)
+    {
+        for (size_t i = 0; i < tiargs->dim; i++)
+        {
+            RootObject *o = (*tiargs)[i];
+            Type *ta = isType(o);
+            if (ta && !ta->deco)
+                return false;
+            if (!ta && !isExpression(o) && !isDsymbol(o))
+                return false;
+        }
+    }
+
+    for (size_t i = 0; i < (fargs ? fargs->dim : 0); i++)
+    {
+        Expression *arg = (*fargs)[i];
+        if (!arg->type || !arg->type->deco)
+            return false;
+
+        // Literals can convert to, and deduce, more than their type says.
+        switch (arg->op)
+        {
+            case TOKint64:
+            case TOKfloat64:
+            case TOKcomplex80:
+            case TOKnull:
+            case TOKstring:
+            case TOKarrayliteral:
+            case TOKassocarrayliteral:
+            case TOKstructliteral:
+            case TOKfunction:
+                return false;
+
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+/*************************************************
+ * Returns true if td has template parameters defaulting to a value
+ * that depends on the call site, such as __FILE__ or __LINE__.
+ */
+
+static bool hasCallSiteDefaults(TemplateDeclaration *td)
+{
+    for (size_t i = 0; i < td->parameters->dim; i++)
+    {
+        TemplateValueParameter *tvp = (*td->parameters)[i]->isTemplateValueParameter();
+        if (!tvp || !tvp->defaultValue)
+            continue;
+
+        switch (tvp->defaultValue->op)
+        {
+            case TOKline:
+            case TOKfile:
+            case TOKfilefullpath:
+            case TOKmodulestring:
+            case TOKfuncstring:
+            case TOKprettyfunc:
+                return true;
+
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+/*************************************************
+ * Find the entry for the given call of the overload set dstart, which is
+ * currently at the given generation.
+ * Stale entries, and those left by recursion frames other than the
+ * current one, are unlinked as they are passed; except for a stale one
+ * with the same key, which is returned in *stale so it can be refilled.
+ */
+
+static FuncResolveEntry *lookupResolveCache(Dsymbol *dstart, size_t generation,
+        Type *tthis, Objects *tiargs, Expressions *fargs, FuncResolveEntry **stale)
+{
+    size_t nargs = fargs ? fargs->dim : 0;
+    FuncResolveEntry **pe = (FuncResolveEntry **)dmd_aaGet(&funcResolveCache, (void *)dstart);
+    *stale = NULL;
+    while (FuncResolveEntry *e = *pe)
+    {
+        if (e->frame != recursionFrame && e->frame != 0)
+        {
+            *pe = e->next;
+            continue;
+        }
+
+        bool match = e->frame == recursionFrame &&
+                     e->tthis == (tthis ? tthis->deco : NULL) && e->nargs == nargs &&
+                     (e->tiargs != NULL) == (tiargs != NULL) &&
+                     (!tiargs || arrayObjectMatch(e->tiargs, tiargs));
+        for (size_t i = 0; match && i < nargs; i++)
+        {
+            Expression *arg = (*fargs)[i];
+            match = e->argtypes[i] == arg->type->deco &&
+                    e->arglvalues[i] == arg->isLvalue();
+        }
+
+        if (e->generation == generation)
+        {
+            if (match)
+                return e;
+        }
+        else if (match && !*stale)
+            *stale = e;
+        else
+        {
+            *pe = e->next;
+            continue;
+        }
+        pe = &e->next;
+    }
+    return NULL;
+}
+
+/*************************************************
+ * Remember the result of a call of the overload set dstart, either by
+ * refilling the stale entry for the same key, or by adding a new one.
+ */
+
+static void addResolveCache(Dsymbol *dstart, size_t generation, Type *tthis,
+        Objects *tiargs, Expressions *fargs, FuncResolveEntry *stale,
+        Match *m, TemplateDeclaration *td_best, Objects *tdargs, size_t ov_index)
+{
+    size_t nargs = fargs ? fargs->dim : 0;
+
+    FuncResolveEntry *e = stale;
+    if (!e)
+    {
+        e = new FuncResolveEntry();
+        e->frame = recursionFrame;
+        e->tthis = tthis ? tthis->deco : NULL;
+        e->tiargs = tiargs ? tiargs->copy() : NULL;
+        e->nargs = nargs;
+        e->argtypes = (const char **)mem.xmalloc(nargs * sizeof(const char *));
+        e->arglvalues = (bool *)mem.xmalloc(nargs * sizeof(bool));
+        for (size_t i = 0; i < nargs; i++)
+        {
+            Expression *arg = (*fargs)[i];
+            e->argtypes[i] = arg->type->deco;
+            e->arglvalues[i] = arg->isLvalue();
+        }
+
+        FuncResolveEntry **pe = (FuncResolveEntry **)dmd_aaGet(&funcResolveCache, (void *)dstart);
+        e->next = *pe;
+        *pe = e;
+    }
+
+    e->generation = generation;
+    e->last = m->last;
+    e->lastf = m->lastf;
+    e->td_best = td_best;
+    e->tdargs = tdargs ? tdargs->copy() : NULL;
+    e->ov_index = ov_index;
+}
+
 /*************************************************
  * Given function arguments, figure out which template function
  * to expand, and return matching result.
@@ -2508,9 +2793,12 @@ void functionResolve(Match *m, Dsymbol *dstart, Loc loc, Scope *sc,
                     pr.sc = sc;
                     pr.dedargs = &dedtypesX;
                     tdx->previous = &pr;                 // add this to threaded list
+                    unsigned frame = recursionFrame;
+                    recursionFrame = ++recursionFrames;
 
                     fd = resolveFuncCall(loc, sc, s, NULL, tthis, fargs, 1);
 
+                    recursionFrame = frame;
                     tdx->previous = pr.prev;             // unlink from threaded list
                 }
                 else if (s->isFuncDeclaration())
@@ -2693,10 +2981,51 @@ void functionResolve(Match *m, Dsymbol *dstart, Loc loc, Scope *sc,
     if (td && td->funcroot)
         dstart = td->funcroot;
 
-    overloadApply(dstart, &p, &ParamDeduce::fp);
+    /* Only a fresh match can be cached, as opover calls this
+     * with the same Match for both the forward and reverse operator.
+     */
+    bool cacheable = !m->lastf && !m->count && m->last == MATCHnomatch &&
+                     isResolveCacheable(sc, tthis, tiargs, fargs);
+    unsigned errors = global.errors + global.gaggedErrors;
+    unsigned dependent = valueDependentMatches;
+    Objects *tdargs = NULL;
+
+    size_t generation = cacheable ? overloadSetGeneration(dstart) : 0;
+
+    FuncResolveEntry *stale = NULL;
+    FuncResolveEntry *ce = cacheable ? lookupResolveCache(dstart, generation, tthis, tiargs, fargs, &stale) : NULL;
+    if (ce)
+    {
+        m->last = ce->last;
+        m->lastf = ce->lastf;
+        m->anyf = ce->lastf;
+        m->nextf = NULL;
+        m->count = 1;
+        p.td_best = ce->td_best;
+        p.ov_index = ce->ov_index;
+        tdargs = ce->tdargs ? ce->tdargs->copy() : NULL;
+        cacheable = false;
+    }
+    else
+    {
+        trackValueDependentMatches++;
+        overloadApply(dstart, &p, &ParamDeduce::fp);
+        trackValueDependentMatches--;
+        if (p.ti_best)
+            tdargs = p.ti_best->tiargs;
+    }
+
+    // Don't cache matches that relied on the values of the arguments,
+    // or that instantiated a template without going through tdargs.
+    if (valueDependentMatches != dependent ||
+        (p.td_best && (!tdargs || hasCallSiteDefaults(p.td_best))))
+    {
+        cacheable = false;
+    }
+    size_t ov_index = p.ov_index;
 
     //printf("td_best = %p, m->lastf = %p\n", p.td_best, m->lastf);
-    if (p.td_best && p.ti_best && m->count == 1)
+    if (p.td_best && tdargs && m->count == 1)
     {
         // Matches to template function
         assert(p.td_best->onemember && p.td_best->onemember->isFuncDeclaration());
@@ -2707,7 +3036,7 @@ void functionResolve(Match *m, Dsymbol *dstart, Loc loc, Scope *sc,
         assert(p.td_best->_scope);
         if (!sc) sc = p.td_best->_scope; // workaround for Type::aliasthisOf
 
-        TemplateInstance *ti = new TemplateInstance(loc, p.td_best, p.ti_best->tiargs);
+        TemplateInstance *ti = new TemplateInstance(loc, p.td_best, tdargs);
         ti->semantic(sc, fargs);
 
         m->lastf = ti->toAlias()->isFuncDeclaration();
@@ -2764,6 +3093,13 @@ void functionResolve(Match *m, Dsymbol *dstart, Loc loc, Scope *sc,
         m->lastf = NULL;
         m->last = MATCHnomatch;
     }
+
+    if (cacheable && m->count == 1 && m->last > MATCHnomatch && m->lastf &&
+        errors == global.errors + global.gaggedErrors)
+    {
+        addResolveCache(dstart, generation, tthis, tiargs, fargs, stale,
+                        m, p.td_best, tdargs, ov_index);
+    }
 }
 
 /*************************************************
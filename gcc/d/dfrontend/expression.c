@@ -2261,7 +2261,7 @@ Expression *Expression::toLvalue(Scope *sc, Expression *e)
 {
     if (!e)
         e = this;
-    else if (!loc.filename)
+    else if (!loc.filename())
         loc = e->loc;
 
     if (e->op == TOKtype)
@@ -2662,7 +2662,7 @@ bool Expression::checkSafety(Scope *sc, FuncDeclaration *f)
     {
         if (sc->flags & SCOPEcompile ? sc->func->isSafeBypassingInference() : sc->func->setUnsafe())
         {
-            if (loc.linnum == 0)  // e.g. implicitly generated dtor
+            if (loc.linnum() == 0)  // e.g. implicitly generated dtor
                 loc = sc->func->loc;
 
             error("@safe %s '%s' cannot call @system %s '%s'",
@@ -2694,7 +2694,7 @@ bool Expression::checkNogc(Scope *sc, FuncDeclaration *f)
     {
         if (sc->flags & SCOPEcompile ? sc->func->isNogcBypassingInference() : sc->func->setGC())
         {
-            if (loc.linnum == 0)  // e.g. implicitly generated dtor
+            if (loc.linnum() == 0)  // e.g. implicitly generated dtor
                 loc = sc->func->loc;
 
             error("@nogc %s '%s' cannot call non-@nogc %s '%s'",
@@ -3042,7 +3042,7 @@ Expression *IntegerExp::toLvalue(Scope *sc, Expression *e)
 {
     if (!e)
         e = this;
-    else if (!loc.filename)
+    else if (!loc.filename())
         loc = e->loc;
     e->error("constant %s is not an lvalue", e->toChars());
     return new ErrorExp();
@@ -6707,7 +6707,7 @@ FileInitExp::FileInitExp(Loc loc, TOK tok)
 Expression *FileInitExp::resolveLoc(Loc loc, Scope *sc)
 {
     //printf("FileInitExp::resolve() %s\n", toChars());
-    const char *s = loc.filename ? loc.filename : sc->_module->ident->toChars();
+    const char *s = loc.filename() ? loc.filename() : sc->_module->ident->toChars();
     Expression *e = new StringExp(loc, (char *)s);
     e = semantic(e, sc);
     e = e->castTo(sc, type);
@@ -6723,7 +6723,7 @@ LineInitExp::LineInitExp(Loc loc)
 
 Expression *LineInitExp::resolveLoc(Loc loc, Scope *sc)
 {
-    Expression *e = new IntegerExp(loc, loc.linnum, Type::tint32);
+    Expression *e = new IntegerExp(loc, loc.linnum(), Type::tint32);
     e = e->castTo(sc, type);
     return e;
 }
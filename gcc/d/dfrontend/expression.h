@@ -93,6 +93,8 @@ bool hasSideEffect(Expression *e);
 bool canThrow(Expression *e, FuncDeclaration *func, bool mustNotThrow);
 Expression *Expression_optimize(Expression *e, int result, bool keepLvalue);
 MATCH implicitConvTo(Expression *e, Type *t);
+extern int trackValueDependentMatches;   // if != 0, count value dependent matches
+extern unsigned valueDependentMatches;   // implicitConvTo() results not implied by the type
 Expression *implicitCastTo(Expression *e, Scope *sc, Type *t);
 Expression *castTo(Expression *e, Scope *sc, Type *t);
 Expression *ctfeInterpret(Expression *);
@@ -1489,6 +1491,10 @@ struct UnionExp
      */
     Expression *copy();
 
+    /* Same as copy(), but allocated in the CTFE arena
+     */
+    Expression *ctfeCopy();
+
 private:
     union
     {
@@ -1423,7 +1423,7 @@ void FuncDeclaration::semantic3(Scope *sc)
             }
         }
         ss->loc = loc;
-        ss->endlinnum = endloc.linnum;
+        ss->endlinnum = endloc.linnum();
         Scope *sc2 = sc->push(ss);
         sc2->func = this;
         sc2->parent = this;
@@ -1639,7 +1639,7 @@ void FuncDeclaration::semantic3(Scope *sc)
             ScopeDsymbol *sym = new ScopeDsymbol();
             sym->parent = sc2->scopesym;
             sym->loc = loc;
-            sym->endlinnum = endloc.linnum;
+            sym->endlinnum = endloc.linnum();
             scout = sc2->push(sym);
         }
 
@@ -1648,7 +1648,7 @@ void FuncDeclaration::semantic3(Scope *sc)
             ScopeDsymbol *sym = new ScopeDsymbol();
             sym->parent = sc2->scopesym;
             sym->loc = loc;
-            sym->endlinnum = endloc.linnum;
+            sym->endlinnum = endloc.linnum();
             sc2 = sc2->push(sym);
 
             AggregateDeclaration *ad2 = isMember2();
@@ -1986,7 +1986,7 @@ void FuncDeclaration::semantic3(Scope *sc)
             ScopeDsymbol *sym = new ScopeDsymbol();
             sym->parent = sc2->scopesym;
             sym->loc = loc;
-            sym->endlinnum = endloc.linnum;
+            sym->endlinnum = endloc.linnum();
             sc2 = sc2->push(sym);
             sc2->flags = (sc2->flags & ~SCOPEcontract) | SCOPErequire;
 
@@ -5198,6 +5198,7 @@ void StaticCtorDeclaration::semantic(Scope *sc)
     if (m)
     {
         m->needmoduleinfo = 1;
+        m->hasctordtor = true;
         //printf("module1 %s needs moduleinfo\n", m->toChars());
     }
 }
@@ -5326,6 +5327,7 @@ void StaticDtorDeclaration::semantic(Scope *sc)
     if (m)
     {
         m->needmoduleinfo = 1;
+        m->hasctordtor = true;
         //printf("module2 %s needs moduleinfo\n", m->toChars());
     }
 }
@@ -5450,7 +5452,7 @@ bool InvariantDeclaration::addPostInvariant()
 static Identifier *unitTestId(Loc loc)
 {
     OutBuffer buf;
-    buf.printf("__unittestL%u_", loc.linnum);
+    buf.printf("__unittestL%u_", loc.linnum());
     return Identifier::generateId(buf.peekString());
 }
 
@@ -117,6 +117,7 @@ struct Param
     bool bug10378;      // use pre-bugzilla 10378 search strategy
     bool vsafe;         // use enhanced @safe checking
     bool showGaggedErrors;  // print gagged errors anyway
+    bool mangleBackrefs;    // compress symbol names with back references
 
     CPU cpu;                // CPU instruction set to target
     BOUNDSCHECK useArrayBounds;
@@ -276,25 +277,43 @@ struct DArray
 };
 
 // file location
+// A position in the source, stored as an offset into the text of all the
+// sources lexed so far.  The file name, line and column are only looked up
+// in the LocTable when asked for.  Offset 0 is no location.
 struct Loc
 {
-    const char *filename;
-    unsigned linnum;
-    unsigned charnum;
+    unsigned offset;
 
     Loc()
     {
-        linnum = 0;
-        charnum = 0;
-        filename = NULL;
+        offset = 0;
     }
 
     Loc(const char *filename, unsigned linnum, unsigned charnum);
 
+    const char *filename() const;
+    unsigned linnum() const;
+    unsigned charnum() const;
+
     const char *toChars() const;
     bool equals(const Loc& loc);
 };
 
+// Records the sources that Locs point into, and where each of their lines
+// starts, as the lexer goes.
+struct LocTable
+{
+    // Reserve offsets for length+1 characters of a source whose first line
+    // is linnum of filename, and return the offset of the first.
+    static unsigned addSource(const char *filename, unsigned linnum, size_t length);
+
+    // A new line starts at offset.
+    static void addLine(unsigned offset);
+
+    // The line after the one containing offset is linnum of filename.
+    static void addLineDirective(unsigned offset, const char *filename, unsigned linnum);
+};
+
 enum LINK
 {
     LINKdefault,
@@ -357,7 +357,7 @@ public:
     {
         if (loc)
         {
-            const char *filename = loc->filename;
+            const char *filename = loc->filename();
             if (filename)
             {
                 if (!this->filename || strcmp(filename, this->filename))
@@ -367,11 +367,12 @@ public:
                 }
             }
 
-            if (loc->linnum)
+            unsigned linnum = loc->linnum();
+            if (linnum)
             {
-                property(linename, loc->linnum);
-                if (loc->charnum)
-                    property(charname, loc->charnum);
+                property(linename, linnum);
+                if (unsigned charnum = loc->charnum())
+                    property(charname, charnum);
             }
         }
     }
@@ -21,6 +21,11 @@
 #include <assert.h>
 #include <time.h>       // for time() and ctime()
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#define LEXER_SSE2 1
+#include <emmintrin.h>
+#endif
+
 #include "rmem.h"
 
 #include "lexer.h"
@@ -67,18 +72,151 @@ CMTableInitializer::CMTableInitializer()
     }
 }
 
+/********************************************
+ * Fast paths for runs of characters that need no attention from the
+ * lexer: blanks, identifiers, and the bodies of comments and strings.
+ * skipRun<Stop>(p, end) returns the first character at or after p for
+ * which Stop::stop() is true.  Every Stop stops at 0, so the run always
+ * ends at the terminator of the buffer.
+ *
+ * With SSE2, sixteen characters are tested at a time for as long as they
+ * all lie before end, then the rest one at a time.
+ */
+
+#if LEXER_SSE2
+// Mask of the characters in v that end a line or the buffer, or that
+// need decoding as UTF-8.
+static inline unsigned eolMask(__m128i v)
+{
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8(0x1A))));
+    return _mm_movemask_epi8(m) | _mm_movemask_epi8(v);
+}
+
+// Mask of the characters in v equal to c.
+static inline unsigned eqMask(__m128i v, char c)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+#endif
+
+static inline bool iseol(utf8_t c)
+{
+    return c == '\n' || c == '\r' || c == 0 || c == 0x1A || (c & 0x80);
+}
+
+struct StopBlank        // ' ' and '\t'
+{
+    static bool stop(utf8_t c) { return c != ' ' && c != '\t'; }
+#if LEXER_SSE2
+    static unsigned stop(__m128i v)
+    {
+        return ~(eqMask(v, ' ') | eqMask(v, '\t')) & 0xFFFF;
+    }
+#endif
+};
+
+struct StopIdent        // [A-Za-z0-9_]
+{
+    static bool stop(utf8_t c) { return !isidchar(c); }
+#if LEXER_SSE2
+    static unsigned stop(__m128i v)
+    {
+        // Signed compares, so characters >= 0x80 are in none of the ranges.
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+        __m128i m = _mm_or_si128(_mm_or_si128(digit, upper), lower);
+        return ~(_mm_movemask_epi8(m) | eqMask(v, '_')) & 0xFFFF;
+    }
+#endif
+};
+
+struct StopLineComment  // body of // comment
+{
+    static bool stop(utf8_t c) { return iseol(c); }
+#if LEXER_SSE2
+    static unsigned stop(__m128i v) { return eolMask(v); }
+#endif
+};
+
+struct StopBlockComment // body of /* */ comment
+{
+    static bool stop(utf8_t c) { return iseol(c) || c == '/'; }
+#if LEXER_SSE2
+    static unsigned stop(__m128i v) { return eolMask(v) | eqMask(v, '/'); }
+#endif
+};
+
+struct StopNestComment  // body of /+ +/ comment
+{
+    static bool stop(utf8_t c) { return iseol(c) || c == '/' || c == '+'; }
+#if LEXER_SSE2
+    static unsigned stop(__m128i v)
+    {
+        return eolMask(v) | eqMask(v, '/') | eqMask(v, '+');
+    }
+#endif
+};
+
+struct StopString       // body of "" string
+{
+    static bool stop(utf8_t c) { return iseol(c) || c == '"' || c == '\\'; }
+#if LEXER_SSE2
+    static unsigned stop(__m128i v)
+    {
+        return eolMask(v) | eqMask(v, '"') | eqMask(v, '\\');
+    }
+#endif
+};
+
+struct StopWysiwyg      // body of r"" and `` strings
+{
+    static bool stop(utf8_t c) { return iseol(c) || c == '"' || c == '`'; }
+#if LEXER_SSE2
+    static unsigned stop(__m128i v)
+    {
+        return eolMask(v) | eqMask(v, '"') | eqMask(v, '`');
+    }
+#endif
+};
+
+template<typename Stop>
+static inline const utf8_t *skipRun(const utf8_t *p, const utf8_t *end)
+{
+#if LEXER_SSE2
+    for (; p + 16 <= end; p += 16)
+    {
+        unsigned mask = Stop::stop(_mm_loadu_si128((const __m128i *)p));
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+#endif
+    while (!Stop::stop(*p))
+        p++;
+    return p;
+}
+
 /*************************** Lexer ********************************************/
 
 OutBuffer Lexer::stringbuffer;
 
 Lexer::Lexer(const char *filename,
         const utf8_t *base, size_t begoffset, size_t endoffset,
-        bool doDocComment, bool commentToken)
+        bool doDocComment, bool commentToken, unsigned linnum)
 {
-    scanloc = Loc(filename, 1, 1);
     //printf("Lexer::Lexer(%p,%d)\n",base,length);
     //printf("lexer.filename = %s\n", filename);
     memset(&token,0,sizeof(token));
+    this->filename = filename;
+    this->linnum = linnum;
+    this->locbase = LocTable::addSource(filename, linnum, endoffset - begoffset) - (unsigned)begoffset;
     this->base = base;
     this->end  = base + endoffset;
     p = base + begoffset;
@@ -131,8 +269,9 @@ Lexer::Lexer(const char *filename,
 
 void Lexer::endOfLine()
 {
-    scanloc.linnum++;
+    linnum++;
     line = p;
+    LocTable::addLine(locbase + (unsigned)(p - base));
 }
 
 
@@ -270,8 +409,9 @@ Token *Lexer::peekPastParen(Token *tk)
 
 void Lexer::scan(Token *t)
 {
-    unsigned lastLine = scanloc.linnum;
+    unsigned lastLine = linnum;
     Loc startLoc;
+    unsigned startLine = 0;
 
     t->blockComment = NULL;
     t->lineComment = NULL;
@@ -292,6 +432,8 @@ void Lexer::scan(Token *t)
             case '\v':
             case '\f':
                 p++;
+                if (*p == ' ' || *p == '\t')
+                    p = skipRun<StopBlank>(p, end);
                 continue;                       // skip white space
 
             case '\r':
@@ -367,10 +509,9 @@ void Lexer::scan(Token *t)
 
                 while (1)
                 {
-                    c = *++p;
-                    if (isidchar(c))
-                        continue;
-                    else if (c & 0x80)
+                    p = skipRun<StopIdent>(p + 1, end);
+                    c = *p;
+                    if (c & 0x80)
                     {   const utf8_t *s = p;
                         unsigned u = decodeUTF();
                         if (isUniAlpha(u))
@@ -475,10 +616,12 @@ void Lexer::scan(Token *t)
                     case '*':
                         p++;
                         startLoc = loc();
+                        startLine = linnum;
                         while (1)
                         {
                             while (1)
-                            {   utf8_t c = *p;
+                            {   p = skipRun<StopBlockComment>(p, end);
+                                utf8_t c = *p;
                                 switch (c)
                                 {
                                     case '/':
@@ -526,14 +669,16 @@ void Lexer::scan(Token *t)
                         }
                         else if (doDocComment && t->ptr[2] == '*' && p - 4 != t->ptr)
                         {   // if /** but not /**/
-                            getDocComment(t, lastLine == startLoc.linnum);
+                            getDocComment(t, lastLine == startLine);
                         }
                         continue;
 
                     case '/':           // do // style comments
                         startLoc = loc();
+                        startLine = linnum;
                         while (1)
-                        {   utf8_t c = *++p;
+                        {   p = skipRun<StopLineComment>(p + 1, end);
+                            utf8_t c = *p;
                             switch (c)
                             {
                                 case '\n':
@@ -554,7 +699,7 @@ void Lexer::scan(Token *t)
                                         return;
                                     }
                                     if (doDocComment && t->ptr[2] == '/')
-                                        getDocComment(t, lastLine == startLoc.linnum);
+                                        getDocComment(t, lastLine == startLine);
                                     p = end;
                                     t->loc = loc();
                                     t->value = TOKeof;
@@ -580,7 +725,7 @@ void Lexer::scan(Token *t)
                             return;
                         }
                         if (doDocComment && t->ptr[2] == '/')
-                            getDocComment(t, lastLine == startLoc.linnum);
+                            getDocComment(t, lastLine == startLine);
 
                         p++;
                         endOfLine();
@@ -590,10 +735,12 @@ void Lexer::scan(Token *t)
                     {   int nest;
 
                         startLoc = loc();
+                        startLine = linnum;
                         p++;
                         nest = 1;
                         while (1)
-                        {   utf8_t c = *p;
+                        {   p = skipRun<StopNestComment>(p, end);
+                            utf8_t c = *p;
                             switch (c)
                             {
                                 case '/':
@@ -653,7 +800,7 @@ void Lexer::scan(Token *t)
                         }
                         if (doDocComment && t->ptr[2] == '+' && p - 4 != t->ptr)
                         {   // if /++ but not /++/
-                            getDocComment(t, lastLine == startLoc.linnum);
+                            getDocComment(t, lastLine == startLine);
                         }
                         continue;
                     }
@@ -1091,6 +1238,9 @@ TOK Lexer::wysiwygStringConstant(Token *t, int tc)
     stringbuffer.reset();
     while (1)
     {
+        const utf8_t *run = skipRun<StopWysiwyg>(p, end);
+        stringbuffer.write(p, run - p);
+        p = run;
         c = *p++;
         switch (c)
         {
@@ -1448,6 +1598,9 @@ TOK Lexer::escapeStringConstant(Token *t, int wide)
     stringbuffer.reset();
     while (1)
     {
+        const utf8_t *run = skipRun<StopString>(p, end);
+        stringbuffer.write(p, run - p);
+        p = run;
         c = *p++;
         switch (c)
         {
@@ -2058,7 +2211,7 @@ TOK Lexer::inreal(Token *t)
     if (isOutOfRange && !isLong)
     {
         const char *suffix = (result == TOKfloat32v || result == TOKimaginary32v) ? "f" : "";
-        error(scanloc, "number '%s%s' is not representable", (char *)stringbuffer.data, suffix);
+        error(loc(), "number '%s%s' is not representable", (char *)stringbuffer.data, suffix);
     }
 #ifdef DEBUG
     switch (result)
@@ -2087,7 +2240,7 @@ TOK Lexer::inreal(Token *t)
 void Lexer::poundLine()
 {
     Token tok;
-    int linnum = this->scanloc.linnum;
+    int linnum = this->linnum;
     char *filespec = NULL;
     Loc loc = this->loc();
 
@@ -2114,9 +2267,10 @@ void Lexer::poundLine()
             case 0x1A:
             case '\n':
             Lnewline:
-                this->scanloc.linnum = linnum;
+                this->linnum = linnum;
                 if (filespec)
-                    this->scanloc.filename = filespec;
+                    this->filename = filespec;
+                LocTable::addLineDirective(this->loc().offset, this->filename, linnum + 1);
                 return;
 
             case '\r':
@@ -2138,7 +2292,7 @@ void Lexer::poundLine()
                 if (memcmp(p, "__FILE__", 8) == 0)
                 {
                     p += 8;
-                    filespec = mem.xstrdup(scanloc.filename);
+                    filespec = mem.xstrdup(filename);
                     continue;
                 }
                 goto Lerr;
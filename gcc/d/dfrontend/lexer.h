@@ -28,7 +28,9 @@ class Lexer
 public:
     static OutBuffer stringbuffer;
 
-    Loc scanloc;                // for error messages
+    const char *filename;       // current file, as set by #line
+    unsigned linnum;            // current line number
+    unsigned locbase;           // Loc offset of base
 
     const utf8_t *base;        // pointer to start of buffer
     const utf8_t *end;         // past end of buffer
@@ -42,7 +44,7 @@ public:
 
     Lexer(const char *filename,
         const utf8_t *base, size_t begoffset, size_t endoffset,
-        bool doDocComment, bool commentToken);
+        bool doDocComment, bool commentToken, unsigned linnum = 1);
 
     TOK nextToken();
     TOK peekNext();
@@ -63,8 +65,9 @@ public:
 
     Loc loc()
     {
-        scanloc.charnum = (unsigned)(1 + p-line);
-        return scanloc;
+        Loc loc;
+        loc.offset = locbase + (unsigned)(p - base);
+        return loc;
     }
 
     void error(const char *format, ...);
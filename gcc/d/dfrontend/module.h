@@ -62,6 +62,8 @@ public:
     static Module *rootModule;
     static DsymbolTable *modules;       // symbol table of all modules
     static Modules amodules;            // array of all modules
+    static unsigned importGeneration;   // bumped each time an import edge is added
+    static unsigned sccGeneration;      // importGeneration when the import SCCs were last computed
     static Dsymbols deferred;   // deferred Dsymbol's needing semantic() run on them
     static Dsymbols deferred2;  // deferred Dsymbol's needing semantic2() run on them
     static Dsymbols deferred3;  // deferred Dsymbol's needing semantic3() run on them
@@ -83,13 +85,16 @@ public:
     int isDocFile;      // if it is a documentation input file, not D source
     bool isPackageFile; // if it is a package.d
     int needmoduleinfo;
+    bool hasctordtor;   // has a static ctor or dtor of its own, set by semantic
 
-    int selfimports;            // 0: don't know, 1: does not, 2: does
+    bool selfimports;           // member of an import cycle, computed by computeImportSCCs()
     bool selfImports();         // returns true if module imports itself
 
-    int rootimports;            // 0: don't know, 1: does not, 2: does
+    bool rootimports;           // transitively imports a root module, maintained by addImport()
     bool rootImports();         // returns true if module imports root module
 
+    unsigned sccIndex;          // strongly connected component of the import graph
+
     int insearch;
     Identifier *searchCacheIdent;
     Dsymbol *searchCacheSymbol; // cached value of search
@@ -103,6 +108,7 @@ public:
     Dsymbols *decldefs;         // top level declarations for this Module
 
     Modules aimports;             // all imported modules
+    Modules importedBy;           // all modules importing this one (reverse of aimports)
 
     unsigned debuglevel;        // debug level
     Strings *debugids;      // debug identifiers
@@ -145,6 +151,8 @@ public:
     static void runDeferredSemantic3();
     static void clearCache();
     int imports(Module *m);
+    void addImport(Module *m);
+    static void computeImportSCCs();
 
     bool isRoot() { return this->importedFrom == this; }
     // true if the module source file is directly
@@ -72,28 +72,35 @@ Parser::Parser(Module *module, const utf8_t *base, size_t length, bool doDocComm
 }
 
 /*********************
- * Use this constructor for string mixins.
+ * Return the file name that the text of a string mixin is reported in.
  * Input:
  *      loc     location in source file of mixin
  */
-Parser::Parser(Loc loc, Module *module, const utf8_t *base, size_t length, bool doDocComment)
-    : Lexer(module ? module->srcfile->toChars() : NULL, base, 0, length, doDocComment, false)
+static const char *mixinFilename(Loc loc)
 {
-    //printf("Parser::Parser()\n");
-    scanloc = loc;
-
 #ifndef IN_GCC
-    if (loc.filename)
+    if (loc.filename())
     {
         /* Create a pseudo-filename for the mixin string, as it may not even exist
          * in the source file.
          */
-        char *filename = (char *)mem.xmalloc(strlen(loc.filename) + 7 + sizeof(loc.linnum) * 3 + 1);
-        sprintf(filename, "%s-mixin-%d", loc.filename, (int)loc.linnum);
-        scanloc.filename = filename;
+        char *filename = (char *)mem.xmalloc(strlen(loc.filename()) + 7 + sizeof(unsigned) * 3 + 1);
+        sprintf(filename, "%s-mixin-%d", loc.filename(), (int)loc.linnum());
+        return filename;
     }
 #endif
+    return loc.filename();
+}
 
+/*********************
+ * Use this constructor for string mixins.
+ * Input:
+ *      loc     location in source file of mixin
+ */
+Parser::Parser(Loc loc, Module *module, const utf8_t *base, size_t length, bool doDocComment)
+    : Lexer(mixinFilename(loc), base, 0, length, doDocComment, false, loc.linnum())
+{
+    //printf("Parser::Parser()\n");
     mod = module;
     md = NULL;
     linkage = LINKd;
@@ -4694,7 +4701,7 @@ void Parser::checkDanglingElse(Loc elseloc)
     if (token.value != TOKelse &&
         token.value != TOKcatch &&
         token.value != TOKfinally &&
-        lookingForElse.linnum != 0)
+        lookingForElse.linnum() != 0)
     {
         warning(elseloc, "else is dangling, add { } after condition at %s", lookingForElse.toChars());
     }
@@ -6937,7 +6944,7 @@ Expression *Parser::parsePrimaryExp()
 
         case TOKfile:
         {
-            const char *s = loc.filename ? loc.filename : mod->ident->toChars();
+            const char *s = loc.filename() ? loc.filename() : mod->ident->toChars();
             e = new StringExp(loc, (char *)s, strlen(s), 0);
             nextToken();
             break;
@@ -6947,8 +6954,8 @@ Expression *Parser::parsePrimaryExp()
         {
             const char *srcfile = mod->srcfile->name->toChars();
             const char *s;
-            if (loc.filename && !FileName::equals(loc.filename, srcfile))
-                s = loc.filename;
+            if (loc.filename() && !FileName::equals(loc.filename(), srcfile))
+                s = loc.filename();
             else
                 s = FileName::combine(mod->srcfilePath, srcfile);
             e = new StringExp(loc, (char *)s, strlen(s), 0);
@@ -6957,7 +6964,7 @@ Expression *Parser::parsePrimaryExp()
         }
 
         case TOKline:
-            e = new IntegerExp(loc, loc.linnum, Type::tint32);
+            e = new IntegerExp(loc, loc.linnum(), Type::tint32);
             nextToken();
             break;
 
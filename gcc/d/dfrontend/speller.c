@@ -18,6 +18,7 @@
 #endif
 
 #include "speller.h"
+#include "rmem.h"
 
 const char idchars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
 
@@ -161,7 +162,8 @@ void *spellerX(const char *seed, size_t seedlen, fp_speller_t fp, void *fparg,
             buf[i + 1] = seed[i];
 
             //printf("tra buf = '%s'\n", buf);
-            if (combineSpellerResult(p, cost, (*fp)(fparg, buf, &ncost), ncost))
+            np = (*fp)(fparg, buf, &ncost);
+            if (combineSpellerResult(p, cost, np, ncost))
                 return p;
 
             buf[i] = seed[i];
@@ -240,6 +242,327 @@ void *speller(const char *seed, fp_speller_t fp, void *fparg, const char *charse
     return NULL;   // didn't find it
 }
 
+/**************************************************
+ * Compute the optimal string alignment distance between a[] and b[],
+ * that is the number of deletions, insertions, substitutions and
+ * transpositions of adjacent characters needed to turn one into the
+ * other, giving up once it exceeds limit.
+ * Returns:
+ *      the distance, or limit + 1 if it is greater than limit
+ */
+
+static size_t editDistance(const char *a, size_t alen, const char *b, size_t blen, size_t limit)
+{
+    if ((alen > blen ? alen - blen : blen - alen) > limit)
+        return limit + 1;
+
+    // Three rows of the distance matrix, for the transposition lookback.
+    size_t *rows = (size_t *)alloca(3 * (blen + 1) * sizeof(size_t));
+    if (!rows)
+        return limit + 1;
+    size_t *prev2 = rows;
+    size_t *prev = rows + (blen + 1);
+    size_t *cur = rows + 2 * (blen + 1);
+
+    for (size_t j = 0; j <= blen; j++)
+        prev[j] = j;
+
+    for (size_t i = 1; i <= alen; i++)
+    {
+        cur[0] = i;
+        size_t rowmin = cur[0];
+        for (size_t j = 1; j <= blen; j++)
+        {
+            size_t d = prev[j - 1] + (a[i - 1] != b[j - 1]);
+            if (prev[j] + 1 < d)
+                d = prev[j] + 1;
+            if (cur[j - 1] + 1 < d)
+                d = cur[j - 1] + 1;
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1] &&
+                prev2[j - 2] + 1 < d)
+                d = prev2[j - 2] + 1;
+            cur[j] = d;
+            if (d < rowmin)
+                rowmin = d;
+        }
+        if (rowmin > limit)
+            return limit + 1;
+
+        size_t *tmp = prev2;
+        prev2 = prev;
+        prev = cur;
+        cur = tmp;
+    }
+    return prev[blen] > limit ? limit + 1 : prev[blen];
+}
+
+/**************************************************
+ * Returns true if word is seed with the m characters at seed[i]
+ * replaced by the n characters at word[i], all of which are in charset.
+ */
+
+static bool isReplacement(const char *seed, size_t seedlen, const char *word, size_t wordlen,
+        const char *charset, size_t i, size_t m, size_t n)
+{
+    if (i + m > seedlen || wordlen + m != seedlen + n)
+        return false;
+    if (memcmp(seed, word, i) != 0 ||
+        memcmp(seed + i + m, word + i + n, seedlen - i - m) != 0)
+        return false;
+    for (size_t k = 0; k < n; k++)
+    {
+        if (!word[i + k] || !charset || !strchr(charset, word[i + k]))
+            return false;
+    }
+    return true;
+}
+
+static long long charRank(const char *charset, char c)
+{
+    return strchr(charset, c) - charset;
+}
+
+/**************************************************
+ * Rank word in the order that spellerX() would have first tried it
+ * for the given distance, so that ties in cost are broken the same way.
+ * Returns:
+ *      the rank, or -1 if spellerX() would never have tried it
+ */
+
+static long long spellerRank(const char *seed, size_t seedlen, const char *word, size_t wordlen,
+        const char *charset, size_t distance)
+{
+    long long best = -1;
+    long long npos = seedlen + 2;
+
+    if (distance == 1)
+    {
+        // Deletions, transpositions, substitutions then insertions.
+        for (size_t i = 0; i <= seedlen; i++)
+        {
+            long long rank = -1;
+            if (isReplacement(seed, seedlen, word, wordlen, charset, i, 1, 0))
+                rank = (0 * npos + i) * 256;
+            else if (i + 1 < seedlen && wordlen == seedlen &&
+                     seed[i] == word[i + 1] && seed[i + 1] == word[i] &&
+                     memcmp(seed, word, i) == 0 &&
+                     memcmp(seed + i + 2, word + i + 2, seedlen - i - 2) == 0)
+                rank = (1 * npos + i) * 256;
+            else if (isReplacement(seed, seedlen, word, wordlen, charset, i, 1, 1))
+                rank = (2 * npos + i) * 256 + charRank(charset, word[i]);
+            else if (isReplacement(seed, seedlen, word, wordlen, charset, i, 0, 1))
+                rank = (3 * npos + i) * 256 + charRank(charset, word[i]);
+
+            if (rank >= 0 && (best < 0 || rank < best))
+                best = rank;
+        }
+        return best;
+    }
+
+    /* An outer deletion, substitution or insertion at i, followed by an
+     * inner deletion, substitution or insertion just after it, each pair
+     * replacing m characters of seed by n new ones.
+     */
+    static const struct { int outer, inner; size_t m, n; } edits[] =
+    {
+        { 0, 0, 2, 0 }, { 0, 1, 2, 1 }, { 0, 2, 1, 1 },
+        { 1, 0, 2, 1 }, { 1, 1, 2, 2 }, { 1, 2, 1, 2 },
+        { 2, 0, 1, 1 }, { 2, 1, 1, 2 }, { 2, 2, 0, 2 },
+    };
+
+    for (size_t e = 0; e < sizeof(edits) / sizeof(edits[0]); e++)
+    {
+        for (size_t i = 0; i <= seedlen; i++)
+        {
+            // The outer deletion and substitution need a character at seed[i].
+            if (edits[e].outer != 2 && i >= seedlen)
+                continue;
+            if (!isReplacement(seed, seedlen, word, wordlen, charset, i, edits[e].m, edits[e].n))
+                continue;
+
+            long long c1 = 0, c2 = 0;
+            if (edits[e].outer == 0)
+                c2 = edits[e].n ? charRank(charset, word[i]) : 0;
+            else
+            {
+                c1 = charRank(charset, word[i]);
+                c2 = edits[e].n > 1 ? charRank(charset, word[i + 1]) : 0;
+            }
+
+            long long rank = (((edits[e].outer * npos + i) * 256 + c1) * 4 + edits[e].inner) * 256 + c2;
+            if (best < 0 || rank < best)
+                best = rank;
+        }
+    }
+    return best;
+}
+
+struct SpellCandidate
+{
+    const char *word;
+    long long rank;
+};
+
+static int cmpSpellCandidate(const void *p1, const void *p2)
+{
+    const SpellCandidate *c1 = (const SpellCandidate *)p1;
+    const SpellCandidate *c2 = (const SpellCandidate *)p2;
+    if (c1->rank != c2->rank)
+        return c1->rank < c2->rank ? -1 : 1;
+    return strcmp(c1->word, c2->word);
+}
+
+/**************************************************
+ * Looks for correct spelling among a set of candidate words, as
+ * returned by SpellIndex::lookup.
+ * Accepts the same distances as speller(), and picks the same word that
+ * speller() would have if the candidates are all the words fp() knows.
+ * Input:
+ *      seed            wrongly spelled word
+ *      fp              search function
+ *      fparg           argument to search function
+ *      charset         character set
+ *      words           candidate words
+ *      nwords          number of candidate words
+ * Returns:
+ *      NULL            no correct spellings found
+ *      void*           value returned by fp() for best possible correct spelling
+ */
+
+void *spellerWords(const char *seed, fp_speller_t fp, void *fparg, const char *charset,
+        const char **words, size_t nwords)
+{
+    size_t seedlen = strlen(seed);
+    size_t maxdist = seedlen < 4 ? seedlen / 2 : 2;
+    if (!maxdist || !nwords)
+        return NULL;
+
+    SpellCandidate *candidates = (SpellCandidate *)mem.xmalloc(nwords * sizeof(SpellCandidate));
+    void *p = NULL;
+
+    for (size_t distance = 1; distance <= maxdist; distance++)
+    {
+        size_t ncandidates = 0;
+        for (size_t i = 0; i < nwords; i++)
+        {
+            const char *word = words[i];
+            size_t wordlen = strlen(word);
+            if (editDistance(seed, seedlen, word, wordlen, distance) != distance)
+                continue;
+
+            long long rank = spellerRank(seed, seedlen, word, wordlen, charset, distance);
+            if (rank < 0)
+                continue;
+
+            candidates[ncandidates].word = word;
+            candidates[ncandidates].rank = rank;
+            ncandidates++;
+        }
+
+        qsort(candidates, ncandidates, sizeof(SpellCandidate), &cmpSpellCandidate);
+
+        int cost = INT_MAX;
+        for (size_t i = 0; i < ncandidates; i++)
+        {
+            int ncost;
+            void *np = (*fp)(fparg, candidates[i].word, &ncost);
+            if (combineSpellerResult(p, cost, np, ncost))
+                break;
+        }
+        if (p)
+            break;
+    }
+
+    mem.xfree(candidates);
+    return p;
+}
+
+/**************************************************
+ * SpellIndex
+ */
+
+struct SpellEntry
+{
+    SpellEntry *next;
+    const char *word;
+};
+
+void SpellIndex::_init(size_t size)
+{
+    table._init(size);
+}
+
+/**************************************************
+ * Add word, which must stay alive as long as the index does,
+ * under itself and every string made by deleting one or two
+ * of its characters.
+ */
+
+void SpellIndex::add(const char *word, size_t len)
+{
+    char *buf = (char *)mem.xmalloc(len + 1);
+
+    // Delete the characters at i and j, where an index of len deletes nothing.
+    for (size_t i = 0; i <= len; i++)
+    {
+        for (size_t j = (i < len ? i + 1 : len); j <= len; j++)
+        {
+            size_t n = 0;
+            for (size_t k = 0; k < len; k++)
+            {
+                if (k != i && k != j)
+                    buf[n++] = word[k];
+            }
+
+            StringValue *sv = table.update(buf, n);
+            SpellEntry *head = (SpellEntry *)sv->ptrvalue;
+
+            // Repeated characters give the same variant more than once.
+            if (head && head->word == word)
+                continue;
+
+            SpellEntry *e = (SpellEntry *)mem.xmalloc(sizeof(SpellEntry));
+            e->next = head;
+            e->word = word;
+            sv->ptrvalue = e;
+        }
+    }
+
+    mem.xfree(buf);
+}
+
+/**************************************************
+ * Call fp for every word in the index that might be within an
+ * edit distance of two of seed.  A word may be passed more than
+ * once, and the caller should check its actual distance.
+ */
+
+void SpellIndex::lookup(const char *seed, size_t seedlen, fp_spellword_t fp, void *fparg)
+{
+    char *buf = (char *)mem.xmalloc(seedlen + 1);
+
+    for (size_t i = 0; i <= seedlen; i++)
+    {
+        for (size_t j = (i < seedlen ? i + 1 : seedlen); j <= seedlen; j++)
+        {
+            size_t n = 0;
+            for (size_t k = 0; k < seedlen; k++)
+            {
+                if (k != i && k != j)
+                    buf[n++] = seed[k];
+            }
+
+            StringValue *sv = table.lookup(buf, n);
+            if (!sv)
+                continue;
+            for (SpellEntry *e = (SpellEntry *)sv->ptrvalue; e; e = e->next)
+                (*fp)(fparg, e->word);
+        }
+    }
+
+    mem.xfree(buf);
+}
+
 
 #if UNITTEST
 
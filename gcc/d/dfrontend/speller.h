@@ -7,9 +7,28 @@
  * https://github.com/D-Programming-Language/dmd/blob/master/src/root/speller.h
  */
 
+#include "stringtable.h"
+
 typedef void *(fp_speller_t)(void *, const char *, int*);
+typedef void (fp_spellword_t)(void *, const char *);
 
 extern const char idchars[];
 
 void *speller(const char *seed, fp_speller_t fp, void *fparg, const char *charset);
+void *spellerWords(const char *seed, fp_speller_t fp, void *fparg, const char *charset,
+        const char **words, size_t nwords);
+
+/* Symmetric delete index of a set of words, mapping every string that
+ * can be made by deleting up to two characters from a word back to it.
+ * Words within an edit distance of two of a seed share such a string
+ * with the seed, so candidates are found with a handful of probes.
+ */
+struct SpellIndex
+{
+    StringTable table;  // deletion variant -> SpellEntry list
+
+    void _init(size_t size = 0);
+    void add(const char *word, size_t len);
+    void lookup(const char *seed, size_t seedlen, fp_spellword_t fp, void *fparg);
+};
 
@@ -65,6 +65,261 @@ private:
         result = new ErrorStatement();
     }
 
+    /* Convert foreach over a char[] or wchar[] with a dchar value to a
+     * ForStatement that decodes inline, only calling the runtime for
+     * characters that are not a single code unit.
+     *   foreach (key, dchar value; a) body =>
+     *   for (T[] tmp = a[], size_t idx = 0; idx < tmp.length; )
+     *   { K key = idx; dchar d = tmp[idx];
+     *     if (d >= 0x80) d = _aApplyDecodec(tmp, idx); else idx += 1;
+     *     dchar value = d; body }
+     *
+     *   foreach_reverse (key, dchar value; a) body =>
+     *   for (T[] tmp = a[], size_t idx = tmp.length; idx > 0; )
+     *   { dchar d = tmp[idx - 1];
+     *     if (d >= 0x80) d = _aApplyRDecodec(tmp, idx); else idx -= 1;
+     *     K key = idx; dchar value = d; body }
+     * Returns NULL if the loop body has to be passed as a delegate to one
+     * of the _aApply functions instead.
+     */
+    Statement *foreachDecode(ForeachStatement *fs, Type *tab, Type *tn, size_t dim)
+    {
+        Loc loc = fs->loc;
+        bool rvs = (fs->op == TOKforeach_reverse);
+
+        // Don't slice a temporary static array.
+        if (tab->ty == Tsarray && !fs->aggr->isLvalue())
+            return NULL;
+
+        Parameter *pkey = (dim == 2) ? (*fs->parameters)[0] : NULL;
+        Parameter *pvalue = (*fs->parameters)[dim - 1];
+        if (pkey)
+        {
+            pkey->type = pkey->type->semantic(loc, sc);
+            pkey->type = pkey->type->addStorageClass(pkey->storageClass);
+            if (!pkey->type->isintegral())
+                return NULL;
+        }
+
+        /* extern(C) dchar _aApplyDecodec(in char[], ref size_t);
+         * and the wchar[] and foreach_reverse versions.
+         */
+        const char *fdname = (tn->ty == Tchar)
+            ? (rvs ? "_aApplyRDecodec" : "_aApplyDecodec")
+            : (rvs ? "_aApplyRDecodew" : "_aApplyDecodew");
+        Parameters *params = new Parameters();
+        params->push(new Parameter(STCin, tn->arrayOf(), NULL, NULL));
+        params->push(new Parameter(STCref, Type::tsize_t, NULL, NULL));
+        FuncDeclaration *fdecode = FuncDeclaration::genCfunc(params, Type::tdchar, fdname);
+
+        ExpInitializer *ie = new ExpInitializer(loc, new SliceExp(loc, fs->aggr, NULL, NULL));
+        VarDeclaration *tmp = new VarDeclaration(loc, tn->arrayOf(), Identifier::generateId("__r"), ie);
+        tmp->storage_class |= STCtemp;
+        tmp->endlinnum = fs->endloc.linnum();
+
+        Expression *tmp_length = new DotIdExp(loc, new VarExp(loc, tmp), Id::length);
+
+        VarDeclaration *idx = new VarDeclaration(loc, Type::tsize_t, Identifier::generateId("__key"), NULL);
+        idx->storage_class |= STCtemp;
+        if (rvs)
+            idx->_init = new ExpInitializer(loc, tmp_length);
+        else
+            idx->_init = new ExpInitializer(loc, new IntegerExp(loc, 0, Type::tsize_t));
+
+        Statements *cs = new Statements();
+        cs->push(new ExpStatement(loc, tmp));
+        cs->push(new ExpStatement(loc, idx));
+        Statement *forinit = new CompoundDeclarationStatement(loc, cs);
+
+        Expression *cond;
+        if (rvs)
+            cond = new CmpExp(TOKgt, loc, new VarExp(loc, idx), new IntegerExp(loc, 0, Type::tsize_t));
+        else
+            cond = new CmpExp(TOKlt, loc, new VarExp(loc, idx), tmp_length);
+
+        // dchar d = tmp[idx];
+        Expression *e = new VarExp(loc, idx);
+        if (rvs)
+            e = new MinExp(loc, e, new IntegerExp(loc, 1, Type::tsize_t));
+        e = new IndexExp(loc, new VarExp(loc, tmp), e);
+        VarDeclaration *vd = new VarDeclaration(loc, Type::tdchar, Identifier::generateId("__d"), new ExpInitializer(loc, e));
+        vd->storage_class |= STCtemp;
+
+        /* Whether the code unit starts or ends a multi-unit sequence, using
+         * the same tests as the _aApply functions.
+         */
+        Expression *multi;
+        if (tn->ty == Tchar)
+            multi = new CmpExp(TOKge, loc, new VarExp(loc, vd), new IntegerExp(loc, 0x80, Type::tdchar));
+        else if (!rvs)
+            multi = new CmpExp(TOKge, loc, new VarExp(loc, vd), new IntegerExp(loc, 0xD800, Type::tdchar));
+        else
+        {
+            multi = new AndAndExp(loc,
+                new CmpExp(TOKge, loc, new VarExp(loc, vd), new IntegerExp(loc, 0xDC00, Type::tdchar)),
+                new CmpExp(TOKle, loc, new VarExp(loc, vd), new IntegerExp(loc, 0xDFFF, Type::tdchar)));
+        }
+
+        // d = _aApplyDecodec(tmp, idx);
+        e = new CallExp(loc, new VarExp(loc, fdecode, false), new VarExp(loc, tmp), new VarExp(loc, idx));
+        e->type = Type::tdchar;                 // do not run semantic on e
+        Statement *sdecode = new ExpStatement(loc, new AssignExp(loc, new VarExp(loc, vd), e));
+
+        // idx += 1;
+        e = new IntegerExp(loc, 1, Type::tsize_t);
+        if (rvs)
+            e = new MinAssignExp(loc, new VarExp(loc, idx), e);
+        else
+            e = new AddAssignExp(loc, new VarExp(loc, idx), e);
+        Statement *snext = new ExpStatement(loc, e);
+
+        Statements *bs = new Statements();
+        Statement *skey = NULL;
+        if (pkey)
+        {
+            ExpInitializer *ei = new ExpInitializer(loc, new CastExp(loc, new VarExp(loc, idx), pkey->type));
+            VarDeclaration *v = new VarDeclaration(loc, pkey->type, pkey->ident, ei);
+            v->storage_class |= STCforeach;
+            skey = new ExpStatement(loc, v);
+        }
+        if (skey && !rvs)
+            bs->push(skey);
+        bs->push(new ExpStatement(loc, vd));
+        bs->push(new IfStatement(loc, NULL, multi, sdecode, snext, fs->endloc));
+        if (skey && rvs)
+            bs->push(skey);
+
+        VarDeclaration *v = new VarDeclaration(loc, pvalue->type, pvalue->ident, new ExpInitializer(loc, new VarExp(loc, vd)));
+        v->storage_class |= STCforeach;
+        bs->push(new ExpStatement(loc, v));
+        bs->push(fs->_body);
+
+        Statement *s = new ForStatement(loc, forinit, cond, NULL, new CompoundStatement(loc, bs), fs->endloc);
+        if (LabelStatement *ls = checkLabeledLoop(sc, fs))
+            ls->gotoTarget = s;
+        return semantic(s, sc);
+    }
+
+    /* Convert foreach over an associative array to a ForStatement that
+     * steps through the buckets with the runtime, so the body is compiled
+     * inline instead of being passed as a delegate to _aaApply.
+     *   foreach (key, value; aa) body =>
+     *   for (auto tmp = aa, void[] b, size_t idx, void* pv,
+     *        void* pk = _aaIterFirst(tmp, b, idx, pv);
+     *        pk; pk = _aaIterNext(tmp, b, idx, pv))
+     *   { K key = *cast(K*)pk; V value = *cast(V*)pv; body }
+     * Returns NULL if the parameter types do not match the associative
+     * array, leaving the error to the _aaApply lowering.
+     */
+    Statement *foreachAA(ForeachStatement *fs, TypeAArray *taa, size_t dim)
+    {
+        Loc loc = fs->loc;
+
+        // Check types, same as for _aaApply.
+        Type *tkv[2] = { taa->index, taa->nextOf() };
+        for (size_t i = 0; i < dim; i++)
+        {
+            Parameter *p = (*fs->parameters)[i];
+            p->type = p->type->semantic(loc, sc);
+            p->type = p->type->addStorageClass(p->storageClass);
+            bool isKey = (dim == 2 && i == 0);
+            Type *t = tkv[isKey ? 0 : 1];
+            if (p->storageClass & STCref)
+            {
+                if (isKey)
+                    t = t->addMod(MODconst);
+                if (!t->constConv(p->type))
+                    return NULL;
+            }
+            else if (!t->implicitConvTo(p->type))
+                return NULL;
+        }
+        if (taa->index->size() == SIZE_INVALID)
+            return NULL;
+
+        /* extern(C) void* _aaIterFirst(void*, out void[], out size_t, out void*);
+         * extern(C) void* _aaIterNext(void*, ref void[], ref size_t, out void*);
+         */
+        Type *tbuckets = Type::tvoid->arrayOf();
+        Parameters *params = new Parameters();
+        params->push(new Parameter(0, Type::tvoidptr, NULL, NULL));
+        params->push(new Parameter(STCout, tbuckets, NULL, NULL));
+        params->push(new Parameter(STCout, Type::tsize_t, NULL, NULL));
+        params->push(new Parameter(STCout, Type::tvoidptr, NULL, NULL));
+        FuncDeclaration *fdfirst = FuncDeclaration::genCfunc(params, Type::tvoidptr, "_aaIterFirst");
+
+        params = new Parameters();
+        params->push(new Parameter(0, Type::tvoidptr, NULL, NULL));
+        params->push(new Parameter(STCref, tbuckets, NULL, NULL));
+        params->push(new Parameter(STCref, Type::tsize_t, NULL, NULL));
+        params->push(new Parameter(STCout, Type::tvoidptr, NULL, NULL));
+        FuncDeclaration *fdnext = FuncDeclaration::genCfunc(params, Type::tvoidptr, "_aaIterNext");
+
+        VarDeclaration *tmp = copyToTemp(0, "__aggr", fs->aggr);
+        tmp->endlinnum = fs->endloc.linnum();
+
+        VarDeclaration *buckets = new VarDeclaration(loc, tbuckets, Identifier::generateId("__buckets"), NULL);
+        buckets->storage_class |= STCtemp;
+        VarDeclaration *idx = new VarDeclaration(loc, Type::tsize_t, Identifier::generateId("__key"), NULL);
+        idx->storage_class |= STCtemp;
+        VarDeclaration *pv = new VarDeclaration(loc, Type::tvoidptr, Identifier::generateId("__pvalue"), NULL);
+        pv->storage_class |= STCtemp;
+
+        // void* pk = _aaIterFirst(tmp, buckets, idx, pv);
+        Expressions *args = new Expressions();
+        args->push(new VarExp(loc, tmp));
+        args->push(new VarExp(loc, buckets));
+        args->push(new VarExp(loc, idx));
+        args->push(new VarExp(loc, pv));
+        Expression *e = new CallExp(loc, new VarExp(loc, fdfirst, false), args);
+        e->type = Type::tvoidptr;               // do not run semantic on e
+        VarDeclaration *pk = new VarDeclaration(loc, Type::tvoidptr, Identifier::generateId("__pkey"), new ExpInitializer(loc, e));
+        pk->storage_class |= STCtemp;
+
+        Statements *cs = new Statements();
+        cs->push(new ExpStatement(loc, tmp));
+        cs->push(new ExpStatement(loc, buckets));
+        cs->push(new ExpStatement(loc, idx));
+        cs->push(new ExpStatement(loc, pv));
+        cs->push(new ExpStatement(loc, pk));
+        Statement *forinit = new CompoundDeclarationStatement(loc, cs);
+
+        // pk = _aaIterNext(tmp, buckets, idx, pv);
+        args = new Expressions();
+        args->push(new VarExp(loc, tmp));
+        args->push(new VarExp(loc, buckets));
+        args->push(new VarExp(loc, idx));
+        args->push(new VarExp(loc, pv));
+        e = new CallExp(loc, new VarExp(loc, fdnext, false), args);
+        e->type = Type::tvoidptr;               // do not run semantic on e
+        Expression *increment = new AssignExp(loc, new VarExp(loc, pk), e);
+
+        /* The entries are reinterpreted from void*, so the casts are given
+         * their types up front to keep them out of the @safe checks, as
+         * the delegate parameters of _aaApply are.
+         */
+        Statements *bs = new Statements();
+        for (size_t i = 0; i < dim; i++)
+        {
+            Parameter *p = (*fs->parameters)[i];
+            bool isKey = (dim == 2 && i == 0);
+            Type *t = (p->storageClass & STCref) ? p->type : tkv[isKey ? 0 : 1];
+            e = new CastExp(loc, new VarExp(loc, isKey ? pk : pv), t->pointerTo());
+            e->type = t->pointerTo();
+            e = new PtrExp(loc, e, t);
+            VarDeclaration *v = new VarDeclaration(loc, p->type, p->ident, new ExpInitializer(loc, e));
+            v->storage_class |= STCforeach | (p->storageClass & (STCref | STC_TYPECTOR));
+            bs->push(new ExpStatement(loc, v));
+        }
+        bs->push(fs->_body);
+
+        Statement *s = new ForStatement(loc, forinit, new VarExp(loc, pk), increment,
+                                        new CompoundStatement(loc, bs), fs->endloc);
+        if (LabelStatement *ls = checkLabeledLoop(sc, fs))
+            ls->gotoTarget = s;
+        return semantic(s, sc);
+    }
+
 public:
     void visit(Statement *s)
     {
@@ -319,7 +574,7 @@ public:
         {
             sym = new ScopeDsymbol();
             sym->parent = sc->scopesym;
-            sym->endlinnum = ss->endloc.linnum;
+            sym->endlinnum = ss->endloc.linnum();
             sc = sc->push(sym);
 
             Statements *a = ss->statement->flatten(sc);
@@ -438,7 +693,7 @@ public:
 
         ScopeDsymbol *sym = new ScopeDsymbol();
         sym->parent = sc->scopesym;
-        sym->endlinnum = fs->endloc.linnum;
+        sym->endlinnum = fs->endloc.linnum();
         sc = sc->push(sym);
 
         sc->noctor++;
@@ -754,7 +1009,7 @@ public:
 
         sym = new ScopeDsymbol();
         sym->parent = sc->scopesym;
-        sym->endlinnum = fs->endloc.linnum;
+        sym->endlinnum = fs->endloc.linnum();
         sc = sc->push(sym);
 
         sc->noctor++;
@@ -804,6 +1059,12 @@ public:
                                     goto Lerror2;
                                 }
                             }
+                            if (tnv->ty == Tdchar)
+                            {
+                                s = foreachDecode(fs, tab, tn, dim);
+                                if (s)
+                                    break;
+                            }
                             goto Lapply;
                         }
                     }
@@ -895,7 +1156,7 @@ public:
                     else
                         tmp = new VarDeclaration(loc, tab->nextOf()->arrayOf(), id, ie);
                     tmp->storage_class |= STCtemp;
-                    tmp->endlinnum = fs->endloc.linnum;
+                    tmp->endlinnum = fs->endloc.linnum();
 
                     Expression *tmp_length = new DotIdExp(loc, new VarExp(loc, tmp), Id::length);
 
@@ -987,6 +1248,9 @@ public:
                     fs->error("only one or two arguments for associative array foreach");
                     goto Lerror2;
                 }
+                s = foreachAA(fs, taa, dim);
+                if (s)
+                    break;
                 goto Lapply;
 
             case Tclass:
@@ -1686,7 +1950,7 @@ public:
 
         ScopeDsymbol *sym = new ScopeDsymbol();
         sym->parent = sc->scopesym;
-        sym->endlinnum = ifs->endloc.linnum;
+        sym->endlinnum = ifs->endloc.linnum();
         Scope *scd = sc->push(sym);
         if (ifs->prm)
         {
@@ -3026,7 +3290,7 @@ public:
         {
             sym = new WithScopeSymbol(ws);
             sym->parent = sc->scopesym;
-            sym->endlinnum = ws->endloc.linnum;
+            sym->endlinnum = ws->endloc.linnum();
         }
         else if (ws->exp->op == TOKtype)
         {
@@ -3038,7 +3302,7 @@ public:
             }
             sym = new WithScopeSymbol(ws);
             sym->parent = sc->scopesym;
-            sym->endlinnum = ws->endloc.linnum;
+            sym->endlinnum = ws->endloc.linnum();
         }
         else
         {
@@ -3062,7 +3326,7 @@ public:
 
                 sym = new WithScopeSymbol(ws);
                 sym->parent = sc->scopesym;
-                sym->endlinnum = ws->endloc.linnum;
+                sym->endlinnum = ws->endloc.linnum();
             }
             else if (t->ty == Tstruct)
             {
@@ -3092,7 +3356,7 @@ public:
                 // Need to set the scope to make use of resolveAliasThis
                 sym->setScope(sc);
                 sym->parent = sc->scopesym;
-                sym->endlinnum = ws->endloc.linnum;
+                sym->endlinnum = ws->endloc.linnum();
             }
             else
             {
@@ -218,6 +218,7 @@ struct PushAttributes
 };
 
 StringTable traitsStringTable;
+SpellIndex traitsSpellIndex;
 
 struct TraitsInitializer
 {
@@ -276,6 +277,7 @@ TraitsInitializer::TraitsInitializer()
     };
 
     traitsStringTable._init(40);
+    traitsSpellIndex._init(40);
 
     for (size_t idx = 0;; idx++)
     {
@@ -283,6 +285,7 @@ TraitsInitializer::TraitsInitializer()
         if (!s) break;
         StringValue *sv = traitsStringTable.insert(s, strlen(s), (void *)s);
         assert(sv);
+        traitsSpellIndex.add(s, strlen(s));
     }
 }
 
@@ -298,6 +301,17 @@ void *trait_search_fp(void *arg, const char *seed, int* cost)
     return sv ? (void*)sv->ptrvalue : NULL;
 }
 
+static void addTraitSpelling(void *param, const char *word)
+{
+    Strings *words = (Strings *)param;
+    for (size_t i = 0; i < words->dim; i++)
+    {
+        if ((*words)[i] == word)
+            return;
+    }
+    words->push(word);
+}
+
 static int fpisTemplate(void *param, Dsymbol *s)
 {
     if (s->isTemplateDeclaration())
@@ -1464,7 +1478,17 @@ Expression *semanticTraits(TraitsExp *e, Scope *sc)
         return pointerBitmap(e);
     }
 
-    if (const char *sub = (const char *)speller(e->ident->toChars(), &trait_search_fp, NULL, idchars))
+    // Don't look for a suggestion if the error won't be printed.
+    const char *sub = NULL;
+    if (!global.gag || global.params.showGaggedErrors)
+    {
+        const char *seed = e->ident->toChars();
+        Strings words;
+        traitsSpellIndex.lookup(seed, strlen(seed), &addTraitSpelling, &words);
+        sub = (const char *)spellerWords(seed, &trait_search_fp, NULL, idchars,
+                                         words.tdata(), words.dim);
+    }
+    if (sub)
         e->error("unrecognized trait '%s', did you mean '%s'?", e->ident->toChars(), sub);
     else
         e->error("unrecognized trait '%s'", e->ident->toChars());
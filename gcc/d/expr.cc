@@ -29,6 +29,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "dfrontend/template.h"
 
 #include "tree.h"
+#include "options.h"
 #include "fold-const.h"
 #include "diagnostic.h"
 #include "langhooks.h"
@@ -42,6 +43,52 @@ along with GCC; see the file COPYING3.  If not see
 #include "d-frontend.h"
 
 
+/* Returns TRUE if the single element append E should check the capacity
+   of the array inline before calling the runtime.  This is done only for
+   local variables, where the capacity can be cached across appends.  */
+
+static bool
+append_capacity_p (CatAssignExp *e)
+{
+  if (!optimize || optimize_size || d_function_chain == NULL)
+    return false;
+
+  /* The runtime has to synchronize appends to shared arrays.  */
+  if (e->e1->op != TOKvar || e->e1->type->isShared ())
+    return false;
+
+  VarDeclaration *vd = ((VarExp *) e->e1)->var->isVarDeclaration ();
+  if (vd == NULL || vd->isDataseg () || (vd->storage_class & STClazy)
+      || vd->toParent2 () != d_function_chain->function)
+    return false;
+
+  return e->e2->type->size () != 0;
+}
+
+/* Returns the capacity cache for the local array variable VD, creating it
+   if this is the first append to VD in the current function.  */
+
+static d_append_cache *
+get_append_cache (VarDeclaration *vd)
+{
+  vec<d_append_cache, va_gc> *caches = d_function_chain->append_caches;
+
+  for (size_t i = 0; i < vec_safe_length (caches); i++)
+    {
+      if ((*caches)[i].var == vd)
+	return &(*caches)[i];
+    }
+
+  d_append_cache cache;
+  cache.var = vd;
+  cache.used = create_temporary_var (build_pointer_type (size_type_node));
+  cache.start = create_temporary_var (ptr_type_node);
+  cache.capend = create_temporary_var (ptr_type_node);
+
+  vec_safe_push (d_function_chain->append_caches, cache);
+  return &d_function_chain->append_caches->last ();
+}
+
 /* Implements the visitor interface to build the GCC trees of all Expression
    AST classes emitted from the D Front-end.
    All visit methods accept one parameter E, which holds the frontend AST
@@ -289,15 +336,16 @@ public:
 	/* For static and dynamic arrays, equality is defined as the lengths of
 	   the arrays matching, and all the elements are equal.  */
 	Type *t1elem = tb1->nextOf ()->toBasetype ();
-	Type *t2elem = tb1->nextOf ()->toBasetype ();
+	Type *t2elem = tb2->nextOf ()->toBasetype ();
 
 	/* Check if comparisons of arrays can be optimized using memcmp.
 	   This will inline EQ expressions as:
 		e1.length == e2.length && memcmp(e1.ptr, e2.ptr, size) == 0;
 	    Or when generating a NE expression:
-		e1.length != e2.length || memcmp(e1.ptr, e2.ptr, size) != 0;  */
-	if ((t1elem->isintegral () || t1elem->ty == Tvoid
-	     || (t1elem->ty == Tstruct && !((TypeStruct *)t1elem)->sym->xeq))
+		e1.length != e2.length || memcmp(e1.ptr, e2.ptr, size) != 0;
+	   Floating point elements and structs with an opEquals are instead
+	   compared one at a time in a loop.  */
+	if ((t1elem->ty == Tvoid || elem_comparison_p (t1elem))
 	    && t1elem->ty == t2elem->ty)
 	  {
 	    tree t1 = d_array_convert (e->e1);
@@ -316,10 +364,11 @@ public:
 	    tree t1ptr = d_array_ptr (t1saved);
 	    tree t2ptr = d_array_ptr (t2saved);
 
-	    /* Compare arrays using memcmp if possible, otherwise for structs,
-	       each field is compared inline.  */
-	    if (t1elem->ty != Tstruct
-		|| identity_compare_p (((TypeStruct *) t1elem)->sym))
+	    /* Compare arrays using memcmp if possible, otherwise each element
+	       is compared inline.  */
+	    if (t1elem->isintegral () || t1elem->ty == Tvoid
+		|| (t1elem->ty == Tstruct && !((TypeStruct *) t1elem)->sym->xeq
+		    && identity_compare_p (((TypeStruct *) t1elem)->sym)))
 	      {
 		tree size = size_mult_expr (t1len, size_int (t1elem->size ()));
 		tree tmemcmp = builtin_decl_explicit (BUILT_IN_MEMCMP);
@@ -329,10 +378,8 @@ public:
 	      }
 	    else
 	      {
-		StructDeclaration *sd = ((TypeStruct *) t1elem)->sym;
-
-		result = build_array_struct_comparison (code, sd, t1len,
-							t1ptr, t2ptr);
+		result = build_array_elem_comparison (code, t1elem, t1len,
+						      t1ptr, t2ptr);
 	      }
 
 	    /* Check array length first before passing to memcmp.
@@ -481,6 +528,54 @@ public:
 	   of the array.  If two arrays compare equal, but are of different
 	   lengths, the shorter array compares as less than the longer.  */
 	Type *telem = tb1->nextOf ()->toBasetype ();
+	Type *t2elem = tb2->nextOf ()->toBasetype ();
+
+	/* Arrays of unsigned bytes compare the same as their memory, so the
+	   result is inlined as:
+		(cmp = memcmp(e1.ptr, e2.ptr, min(e1.length, e2.length))) != 0
+		  ? cmp OP 0 : e1.length OP e2.length;  */
+	if ((telem->ty == Tuns8 || telem->ty == Tchar || telem->ty == Tbool)
+	    && telem->ty == t2elem->ty)
+	  {
+	    tree t1 = d_array_convert (e->e1);
+	    tree t2 = d_array_convert (e->e2);
+
+	    /* Make temporaries to prevent multiple evaluations.  */
+	    tree t1saved = d_save_expr (t1);
+	    tree t2saved = d_save_expr (t2);
+
+	    tree t1len = d_save_expr (d_array_length (t1saved));
+	    tree t2len = d_save_expr (d_array_length (t2saved));
+	    tree minlen = fold_build2 (MIN_EXPR, size_type_node, t1len, t2len);
+	    minlen = d_save_expr (minlen);
+
+	    /* Don't pass a null pointer to memcmp if either array is empty.  */
+	    tree tmemcmp = builtin_decl_explicit (BUILT_IN_MEMCMP);
+	    tmemcmp = build_call_expr (tmemcmp, 3, d_array_ptr (t1saved),
+				       d_array_ptr (t2saved), minlen);
+	    tmemcmp = build_condition (integer_type_node,
+				       build_boolop (EQ_EXPR, minlen,
+						     size_zero_node),
+				       integer_zero_node, tmemcmp);
+	    tmemcmp = d_save_expr (tmemcmp);
+
+	    result = build_condition (bool_type_node,
+				      build_boolop (NE_EXPR, tmemcmp,
+						    integer_zero_node),
+				      build_boolop (code, tmemcmp,
+						    integer_zero_node),
+				      build_boolop (code, t1len, t2len));
+
+	    /* Ensure left-to-right order of evaluation.  */
+	    if (TREE_SIDE_EFFECTS (t2))
+	      result = compound_expr (t2saved, result);
+
+	    if (TREE_SIDE_EFFECTS (t1))
+	      result = compound_expr (t1saved, result);
+
+	    this->result_ = d_convert (build_ctype (e->type), result);
+	    return;
+	  }
 
 	tree call = build_libcall (LIBCALL_ADCMP2, Type::tint32, 3,
 				   d_array_convert (e->e1),
@@ -829,6 +924,60 @@ public:
     this->result_ = convert_expr (exp, e1b->type, e->type);
   }
 
+  /* Build the inline path for the single element append E, which uses
+     the capacity cached for the array to store into the block directly.
+     If the array does not end at the used length of the cached block, or
+     the block has no room left, SLOWPATH is called to grow it instead,
+     and the cache is then refreshed from the block the array is now in.
+     TINFO is the TypeInfo of the array type.  */
+
+  tree build_append_capacity (CatAssignExp *e, tree tinfo, tree slowpath)
+  {
+    VarDeclaration *vd = ((VarExp *) e->e1)->var->isVarDeclaration ();
+    d_append_cache *cache = get_append_cache (vd);
+
+    tree arr = build_expr (e->e1);
+    tree size = size_int (e->e2->type->size ());
+
+    /* The array only ends inside the block if the cache is valid, so its
+       capacity end is checked first, as it is null otherwise.  */
+    tree end = build_offset (build_nop (ptr_type_node, d_array_ptr (arr)),
+			     size_mult_expr (d_array_length (arr), size));
+    end = d_save_expr (end);
+
+    tree used = indirect_ref (size_type_node, cache->used);
+    tree fits = build_boolop (LE_EXPR, build_offset (end, size),
+			      cache->capend);
+    fits = build_boolop (TRUTH_ANDIF_EXPR, fits,
+			 build_boolop (EQ_EXPR, end,
+				       build_offset (cache->start, used)));
+
+    /* Claim the space in the block, then extend the array over it.  */
+    tree length = d_array_length (arr);
+    tree fastpath = modify_expr (used, fold_build2 (PLUS_EXPR, size_type_node,
+						    used, size));
+    fastpath = compound_expr (fastpath,
+			      modify_expr (length,
+					   fold_build2 (PLUS_EXPR,
+							TREE_TYPE (length),
+							length,
+							size_one_node)));
+    fastpath = compound_expr (fastpath, arr);
+
+    /* Grow the array, then look up the block it was moved to.  */
+    slowpath = d_save_expr (slowpath);
+    tree refresh = build_libcall (LIBCALL_ARRAYAPPENDCAPACITY,
+				  Type::tvoidptr, 4, tinfo,
+				  build_nop (ptr_type_node,
+					     d_array_ptr (slowpath)),
+				  build_address (cache->start),
+				  build_address (cache->capend));
+    refresh = build_nop (TREE_TYPE (cache->used), refresh);
+    slowpath = compound_expr (modify_expr (cache->used, refresh), slowpath);
+
+    return build_condition (build_ctype (e->type), fits, fastpath, slowpath);
+  }
+
   /* Build a concat assignment expression.  The right operand is appended
      to the the left operand.  */
 
@@ -869,6 +1018,10 @@ public:
 	    /* Append an element.  */
 	    tree result = build_libcall (LIBCALL_ARRAYAPPENDCTX, e->type, 3,
 					 tinfo, ptr, size_one_node);
+
+	    if (append_capacity_p (e))
+	      result = this->build_append_capacity (e, tinfo, result);
+
 	    result = d_save_expr (result);
 
 	    /* Assign e2 to last element.  */
@@ -1250,9 +1403,8 @@ public:
 	/* Generate the index.  */
 	tree index = build_expr (e->e2);
 
-	/* If it's a static array and the index is constant, the front end has
-	   already checked the bounds.  */
-	if (tb1->ty != Tpointer && !e->indexIsInBounds)
+	/* Check the bounds, unless they are known to hold already.  */
+	if (tb1->ty != Tpointer && index_bounds_check_p (e))
 	  index = build_bounds_condition (e->e2->loc, index, length, false);
 
 	/* Index the .ptr  */
@@ -1370,28 +1522,20 @@ public:
     tree upr_tree = d_save_expr (build_expr (e->upr));
     tree newlength;
 
-    if (!e->upperIsInBounds)
+    if (length && slice_upper_check_p (e))
+      newlength = build_bounds_condition (e->upr->loc, upr_tree, length, true);
+    else
       {
-	if (length)
-	  {
-	    newlength = build_bounds_condition (e->upr->loc, upr_tree,
-						length, true);
-	  }
-	else
-	  {
-	    /* Still need to check bounds lwr <= upr for pointers.  */
-	    gcc_assert (tb1->ty == Tpointer);
-	    newlength = upr_tree;
-	  }
+	/* Still need to check bounds lwr <= upr for pointers.  */
+	gcc_assert (length || tb1->ty == Tpointer);
+	newlength = upr_tree;
       }
-    else
-      newlength = upr_tree;
 
     if (lwr_tree)
       {
 	/* Enforces lwr <= upr. No need to check lwr <= length as
 	   we've already ensured that upr <= length.  */
-	if (!e->lowerIsLessThanUpper)
+	if (slice_lower_check_p (e))
 	  {
 	    tree cond = build_bounds_condition (e->lwr->loc, lwr_tree,
 						upr_tree, true);
@@ -1705,7 +1849,10 @@ public:
 
 	    /* Static method; ignore the object instance.  */
 	    if (!ad)
-	      callee = build_address (fndecl);
+	      {
+		record_inline_import (fd);
+		callee = build_address (fndecl);
+	      }
 	    else
 	      {
 		tree thisexp = build_expr (dve->e1);
@@ -1723,7 +1870,10 @@ public:
 		    fndecl = build_vindex_ref (thisexp, fntype, fd->vtblIndex);
 		  }
 		else
-		  fndecl = build_address (fndecl);
+		  {
+		    record_inline_import (fd);
+		    fndecl = build_address (fndecl);
+		  }
 
 		callee = build_method_call (fndecl, thisexp, fd->type);
 	      }
@@ -1777,6 +1927,8 @@ public:
 	    /* Continue compiling...  */
 	    object = null_pointer_node;
 	  }
+	else
+	  record_inline_import (fd);
       }
     else
       {
@@ -3134,3 +3286,36 @@ build_return_dtor (Expression *e, Type *type, TypeFunction *tf)
   return result;
 }
 
+/* Declare the append capacity caches used by the current function in the
+   outermost scope BLOCK.  Returns BODY, with the caches cleared before it
+   so that the first append to each array always queries the runtime.  */
+
+tree
+declare_append_caches (tree block, tree body)
+{
+  vec<d_append_cache, va_gc> *caches = d_function_chain->append_caches;
+
+  if (vec_safe_is_empty (caches))
+    return body;
+
+  push_stmt_list ();
+
+  for (size_t i = 0; i < caches->length (); i++)
+    {
+      tree vars[3] = { (*caches)[i].used, (*caches)[i].start,
+		       (*caches)[i].capend };
+
+      for (size_t j = 0; j < 3; j++)
+	{
+	  DECL_CHAIN (vars[j]) = BLOCK_VARS (block);
+	  BLOCK_VARS (block) = vars[j];
+	  add_stmt (build_assign (INIT_EXPR, vars[j],
+				  build_zero_cst (TREE_TYPE (vars[j]))));
+	}
+    }
+
+  add_stmt (body);
+  vec_free (d_function_chain->append_caches);
+
+  return pop_stmt_list ();
+}
@@ -24,6 +24,7 @@ along with GCC; see the file COPYING3.  If not see
 {"@d",
   "%{!E:cc1d %i %(cc1_options) %I %{nostdinc*} %{i*} %{I*} %{J*} \
     %{MD:-MD %b.deps} %{MMD:-MMD %b.deps} \
+    %{ffingerprint:%{!ffingerprint=*:-ffingerprint=%{!o:%b.fp}%{o*:%.fp%*}}} \
     %{M} %{MM} %{MF*} %{MG} %{MP} %{MQ*} %{MT*} \
     %{X:-Xf %b.json} %{Xf*} \
     %{v} %{!fsyntax-only:%(invoke_as)}}", 0, 1, 0 },
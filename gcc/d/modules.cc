@@ -102,6 +102,7 @@ enum module_info_flags
   MIimportedModules = 0x400,
   MIlocalClasses    = 0x800,
   MIname	    = 0x1000,
+  MIctorDependencies = 0x2000,
 };
 
 /* The ModuleInfo information structure for the module currently being compiled.
@@ -452,6 +453,55 @@ register_moduleinfo (Module *decl, tree minfo)
   first_module = false;
 }
 
+/* Collect into DEPS the modules with static constructors or destructors that
+   module DECL depends on, looking through the imported modules that have
+   none.  Only the imports written to importedModules are searched, as those
+   are all the runtime sees.  The imports of a module that is not being
+   compiled are not all known, as function-local imports are only found by
+   semantic3, so such a module is added as it is and the runtime searches it
+   instead.  VISITED holds the modules already searched.  */
+
+static void
+find_ctor_dependencies (Module *decl, hash_set<Module *> &visited,
+			vec<Module *> &deps)
+{
+  for (size_t i = 0; i < decl->aimports.dim; i++)
+    {
+      Module *mi = decl->aimports[i];
+      if (!mi->needmoduleinfo || visited.add (mi))
+	continue;
+
+      if (mi->hasctordtor || !mi->isRoot ())
+	deps.safe_push (mi);
+      else
+	find_ctor_dependencies (mi, visited, deps);
+    }
+}
+
+/* Return the list of modules whose constructors must be run before those of
+   module DECL, so that the runtime need not sort the constructors itself.
+   This is the search done by ModuleGroup.sortCtors in rt/minfo.d, and is only
+   valid if the front-end knows about all of DECL's own constructors.  Those
+   from template instances are attributed to the template's module, so if they
+   don't agree, no list is given and the runtime falls back to sorting.  */
+
+static vec<Module *>
+get_ctor_dependencies (Module *decl, bool *valid)
+{
+  vec<Module *> deps = vNULL;
+
+  bool has_ctors = (decl->sctor || decl->sdtor
+		    || decl->ssharedctor || decl->sshareddtor);
+  *valid = (has_ctors && decl->hasctordtor);
+  if (!*valid)
+    return deps;
+
+  hash_set<Module *> visited;
+  visited.add (decl);
+  find_ctor_dependencies (decl, visited, deps);
+  return deps;
+}
+
 /* Convenience function for layout_moduleinfo_fields.  Adds a field of TYPE to
    the moduleinfo record at OFFSET, incrementing the offset to the next field
    position.  No alignment is taken into account, all fields are packed.  */
@@ -469,7 +519,8 @@ layout_moduleinfo_field (tree type, tree rec_type, HOST_WIDE_INT& offset)
    basis, this is done to keep its size to a minimum.  */
 
 static tree
-layout_moduleinfo_fields (Module *decl, tree type)
+layout_moduleinfo_fields (Module *decl, tree type, size_t flags,
+			  const vec<Module *> &ctordeps)
 {
   HOST_WIDE_INT offset = int_size_in_bytes (type);
   type = copy_aggregate_type (type);
@@ -528,6 +579,16 @@ layout_moduleinfo_fields (Module *decl, tree type)
 			       type, offset);
     }
 
+  /* Followed by the constructor dependencies, which may be empty.  */
+  if (flags & MIctorDependencies)
+    {
+      layout_moduleinfo_field (size_type_node, type, offset);
+      if (ctordeps.length ())
+	layout_moduleinfo_field (make_array_type (Type::tvoidptr,
+						  ctordeps.length ()),
+				 type, offset);
+    }
+
   /* Lastly, the name of the module is a static char array.  */
   size_t namelen = strlen (decl->toPrettyChars ()) + 1;
   layout_moduleinfo_field (make_array_type (Type::tchar, namelen),
@@ -584,10 +645,16 @@ layout_moduleinfo (Module *decl)
   if (!decl->needmoduleinfo)
     flags |= MIstandalone;
 
+  bool ctordeps_p;
+  vec<Module *> ctordeps = get_ctor_dependencies (decl, &ctordeps_p);
+  if (ctordeps_p)
+    flags |= MIctorDependencies;
+
   flags |= MIname;
 
   tree minfo = get_moduleinfo_decl (decl);
-  tree type = layout_moduleinfo_fields (decl, TREE_TYPE (minfo));
+  tree type = layout_moduleinfo_fields (decl, TREE_TYPE (minfo), flags,
+					ctordeps);
 
   /* Put out the two named fields in a ModuleInfo decl:
 	uint flags;
@@ -610,6 +677,7 @@ layout_moduleinfo (Module *decl)
 	void function() unitTest;
 	ModuleInfo*[] importedModules;
 	TypeInfo_Class[] localClasses;
+	ModuleInfo*[] ctorDependencies;
 	char[N] name;
    */
   if (flags & MItlsctor)
@@ -675,6 +743,28 @@ layout_moduleinfo (Module *decl)
 			      build_constructor (satype, elms));
     }
 
+  if (flags & MIctorDependencies)
+    {
+      CONSTRUCTOR_APPEND_ELT (minit, NULL_TREE, size_int (ctordeps.length ()));
+
+      if (ctordeps.length ())
+	{
+	  vec<constructor_elt, va_gc> *elms = NULL;
+	  tree satype = make_array_type (Type::tvoidptr, ctordeps.length ());
+
+	  for (size_t i = 0; i < ctordeps.length (); i++)
+	    {
+	      tree mref = build_address (get_moduleinfo_decl (ctordeps[i]));
+	      CONSTRUCTOR_APPEND_ELT (elms, size_int (i), mref);
+	    }
+
+	  CONSTRUCTOR_APPEND_ELT (minit, NULL_TREE,
+				  build_constructor (satype, elms));
+	}
+    }
+
+  ctordeps.release ();
+
   if (flags & MIname)
     {
       /* Put out module name as a 0-terminated C-string, to save bytes.  */
@@ -246,10 +246,22 @@ public:
   {
     location_t saved_location = input_location;
     input_location = get_linemap (s->loc);
+    start_bounds_checks (s);
     s->accept (this);
+    record_bounds_checks (s);
     input_location = saved_location;
   }
 
+  /* Like build_stmt, but for the statement S that begins a branch, a loop
+     body, or a handler.  As S can be reached without running the code
+     compiled just before it, nothing checked by that code holds here.  */
+
+  void build_branch_stmt (Statement *s)
+  {
+    forget_bounds_checks ();
+    this->build_stmt (s);
+  }
+
   /* Start a new scope for a KIND statement.
      Each user-declared variable will have a binding contour that begins
      where the variable is declared and ends at it's containing scope.  */
@@ -544,7 +556,7 @@ public:
     if (s->ifbody)
       {
 	push_stmt_list ();
-	this->build_stmt (s->ifbody);
+	this->build_branch_stmt (s->ifbody);
 	ifbody = pop_stmt_list ();
       }
 
@@ -552,7 +564,7 @@ public:
     if (s->elsebody)
       {
 	push_stmt_list ();
-	this->build_stmt (s->elsebody);
+	this->build_branch_stmt (s->elsebody);
 	elsebody = pop_stmt_list ();
       }
 
@@ -592,7 +604,7 @@ public:
     if (s->_body)
       {
 	tree lcontinue = this->push_continue_label (s);
-	this->build_stmt (s->_body);
+	this->build_branch_stmt (s->_body);
 	this->pop_continue_label (lcontinue);
       }
 
@@ -633,9 +645,11 @@ public:
 
     if (s->_body)
       {
+	size_t nbounds = push_loop_bounds (s);
 	tree lcontinue = this->push_continue_label (s);
-	this->build_stmt (s->_body);
+	this->build_branch_stmt (s->_body);
 	this->pop_continue_label (lcontinue);
+	pop_loop_bounds (nbounds);
       }
 
     if (s->increment)
@@ -1042,7 +1056,7 @@ public:
 	if (statement != NULL)
 	  {
 	    tree lcontinue = this->push_continue_label (statement);
-	    this->build_stmt (statement);
+	    this->build_branch_stmt (statement);
 	    this->pop_continue_label (lcontinue);
 	  }
       }
@@ -1178,7 +1192,7 @@ public:
 	      }
 
 	    if (vcatch->handler)
-	      this->build_stmt (vcatch->handler);
+	      this->build_branch_stmt (vcatch->handler);
 
 	    tree catchbody = this->end_scope ();
 
@@ -1226,7 +1240,7 @@ public:
 
     this->start_scope (level_finally);
     if (s->finalbody)
-      this->build_stmt (s->finalbody);
+      this->build_branch_stmt (s->finalbody);
 
     tree finally = this->end_scope ();
 
@@ -21,12 +21,14 @@ along with GCC; see the file COPYING3.  If not see
 
 #include "dfrontend/aggregate.h"
 #include "dfrontend/enum.h"
+#include "dfrontend/expression.h"
 #include "dfrontend/module.h"
 #include "dfrontend/mtype.h"
 #include "dfrontend/template.h"
 #include "dfrontend/target.h"
 
 #include "tree.h"
+#include "options.h"
 #include "fold-const.h"
 #include "diagnostic.h"
 #include "stringpool.h"
@@ -89,6 +91,24 @@ enum tinfo_kind
 
 static GTY(()) tree tinfo_types[TK_END];
 
+/* The names of each kind of TypeInfo, for -fdump-d-typeinfo.  */
+
+static const char *tinfo_names[TK_END] =
+{
+  "TypeInfo", "TypeInfo_Class", "TypeInfo_Interface", "TypeInfo_Struct",
+  "TypeInfo_Pointer", "TypeInfo_Array", "TypeInfo_StaticArray",
+  "TypeInfo_AssociativeArray", "TypeInfo_Vector", "TypeInfo_Enum",
+  "TypeInfo_Function", "TypeInfo_Delegate", "TypeInfo_Tuple",
+  "TypeInfo_Const", "TypeInfo_Invariant", "TypeInfo_Shared",
+  "TypeInfo_Inout", "__cpp_type_info_ptr",
+};
+
+/* The number of TypeInfo declarations of each kind asked for, and the number
+   written out to the object file.  */
+
+static unsigned tinfo_requested[TK_END];
+static unsigned tinfo_emitted[TK_END];
+
 /* Return the kind of TypeInfo used to describe TYPE.  */
 
 static tinfo_kind
@@ -222,7 +242,8 @@ create_tinfo_types (Module *mod)
 			  array_type_node, array_type_node, array_type_node,
 			  array_type_node, ptr_type_node, ptr_type_node,
 			  ptr_type_node, uint_type_node, ptr_type_node,
-			  array_type_node, ptr_type_node, ptr_type_node, NULL);
+			  array_type_node, ptr_type_node, ptr_type_node,
+			  array_type_node, NULL);
 
   /* Create all frontend TypeInfo classes declarations.  We rely on all
      existing, even if only just as stubs.  */
@@ -286,6 +307,178 @@ create_tinfo_types (Module *mod)
 			    ClassDeclaration::object);
 }
 
+/* Set the element in BITS for each word of TYPE that may hold a pointer
+   into the GC heap, where TYPE starts at byte OFFSET into the object.
+   Returns false if a pointer is not word aligned, in which case the
+   object can only be scanned conservatively.  */
+
+static bool
+pointer_bitmap_type (Type *type, dinteger_t offset, vec<bool> &bits)
+{
+  const dinteger_t ptrsize = Target::ptrsize;
+  Type *tb = type->toBasetype ();
+
+  switch (tb->ty)
+    {
+    case Tpointer:
+    case Tclass:
+    case Taarray:
+    case Tnull:
+      if (offset % ptrsize != 0)
+	return false;
+      bits[offset / ptrsize] = true;
+      return true;
+
+    case Tarray:
+      /* Only the ptr field of {length, ptr}.  */
+      return pointer_bitmap_type (Type::tvoidptr, offset + ptrsize, bits);
+
+    case Tdelegate:
+      /* Only the context pointer of {ptr, funcptr}.  */
+      return pointer_bitmap_type (Type::tvoidptr, offset, bits);
+
+    case Tsarray:
+      {
+	TypeSArray *tsa = (TypeSArray *) tb;
+	Type *etype = tsa->next->toBasetype ();
+	dinteger_t dim = tsa->dim->toUInteger ();
+
+	/* Anything could be stored in a void[N].  */
+	if (etype->ty == Tvoid)
+	  {
+	    for (dinteger_t i = offset / ptrsize;
+		 i * ptrsize < offset + dim; i++)
+	      bits[i] = true;
+	    return true;
+	  }
+
+	if (!etype->hasPointers ())
+	  return true;
+
+	dinteger_t esize = etype->size ();
+	for (dinteger_t i = 0; i < dim; i++)
+	  {
+	    if (!pointer_bitmap_type (etype, offset + i * esize, bits))
+	      return false;
+	  }
+	return true;
+      }
+
+    case Tstruct:
+      {
+	StructDeclaration *sd = ((TypeStruct *) tb)->sym;
+	if (!tb->hasPointers ())
+	  return true;
+
+	/* Overlapping fields of unions are merged together.  */
+	for (size_t i = 0; i < sd->fields.dim; i++)
+	  {
+	    VarDeclaration *field = sd->fields[i];
+	    if (!pointer_bitmap_type (field->type, offset + field->offset, bits))
+	      return false;
+	  }
+	return true;
+      }
+
+    default:
+      return true;
+    }
+}
+
+/* Build the pointer bitmap for the GC to precisely scan instances of the
+   aggregate AD.  This is used as the RTInfo when object.RTInfo does not
+   provide one (see aggregate_rtinfo), and is laid out as an array of size_t,
+   the first element being the number of words in AD, followed by one bit
+   per word, set if the word may hold a pointer.  Returns `1' if AD can only be scanned
+   conservatively.  */
+
+static tree
+build_pointer_bitmap (AggregateDeclaration *ad)
+{
+  const dinteger_t ptrsize = Target::ptrsize;
+  const dinteger_t bits_per_word = ptrsize * BITS_PER_UNIT;
+  dinteger_t nwords = (ad->structsize + ptrsize - 1) / ptrsize;
+
+  vec<bool> bits = vNULL;
+  bits.safe_grow_cleared (nwords);
+
+  bool precise = true;
+  if (ClassDeclaration *cd = ad->isClassDeclaration ())
+    {
+      /* The vtable is static data, but the monitor may point anywhere.  */
+      if (!cd->isCPPclass ())
+	bits[1] = true;
+
+      for (ClassDeclaration *bcd = cd; bcd && precise; bcd = bcd->baseClass)
+	{
+	  for (size_t i = 0; i < bcd->fields.dim && precise; i++)
+	    {
+	      VarDeclaration *field = bcd->fields[i];
+	      precise = pointer_bitmap_type (field->type, field->offset, bits);
+	    }
+	}
+    }
+  else
+    precise = pointer_bitmap_type (ad->type, 0, bits);
+
+  if (!precise)
+    {
+      bits.release ();
+      return size_one_node;
+    }
+
+  dinteger_t length = 1 + (nwords + bits_per_word - 1) / bits_per_word;
+  vec<constructor_elt, va_gc> *elms = NULL;
+  vec_safe_grow (elms, length);
+
+  (*elms)[0].index = size_int (0);
+  (*elms)[0].value = size_int (nwords);
+
+  for (dinteger_t i = 1; i < length; i++)
+    {
+      unsigned HOST_WIDE_INT word = 0;
+      for (dinteger_t j = 0; j < bits_per_word; j++)
+	{
+	  dinteger_t wordi = (i - 1) * bits_per_word + j;
+	  if (wordi < nwords && bits[wordi])
+	    word |= (unsigned HOST_WIDE_INT) 1 << j;
+	}
+
+      (*elms)[i].index = size_int (i);
+      (*elms)[i].value = build_int_cstu (size_type_node, word);
+    }
+
+  bits.release ();
+
+  tree type = build_array_type (size_type_node,
+				build_index_type (size_int (length - 1)));
+  tree decl = build_artificial_decl (type, build_constructor (type, elms));
+  TREE_READONLY (decl) = 1;
+  DECL_EXTERNAL (decl) = 0;
+  d_pushdecl (decl);
+
+  return build_address (decl);
+}
+
+/* Return the RTInfo that object.RTInfo gives for the aggregate AD, or NULL if
+   it gives none.  The template in druntime is `enum RTInfo = null', which
+   the front-end evaluates and stores for every aggregate, so a null value
+   means that the compiler should build the pointer bitmap itself.  */
+
+static Expression *
+aggregate_rtinfo (AggregateDeclaration *ad)
+{
+  Expression *e = ad->getRTInfo;
+
+  if (e == NULL || e->op == TOKnull)
+    return NULL;
+
+  if (e->op == TOKint64 && e->toInteger () == 0)
+    return NULL;
+
+  return e;
+}
+
 /* Implements the visitor interface to build the TypeInfo layout of all
    TypeInfoDeclaration AST classes emitted from the D Front-end.
    All visit methods accept one parameter D, which holds the frontend AST
@@ -397,6 +590,46 @@ class TypeInfoVisitor : public Visitor
     return build_constructor (arrtype, elms);
   }
 
+  /* Write out the ancestors field of class CD, the ClassInfo of each class
+     in its inheritance chain, indexed by depth from Object down to CD.
+     C++ classes have no D ClassInfo chain to check, so the list is empty.
+     COM classes defined in D still get one, as they can derive from plain
+     D classes that are checked this way.  */
+
+  void layout_ancestors (ClassDeclaration *cd)
+  {
+    if (cd->isCPPclass ())
+      {
+	this->layout_field (null_array_node);
+	return;
+      }
+
+    size_t depth = 0;
+    for (ClassDeclaration *bcd = cd->baseClass; bcd; bcd = bcd->baseClass)
+      depth++;
+
+    vec<constructor_elt, va_gc> *elms = NULL;
+    vec_safe_grow (elms, depth + 1);
+
+    size_t i = depth;
+    for (ClassDeclaration *bcd = cd; bcd; bcd = bcd->baseClass, i--)
+      {
+	(*elms)[i].index = size_int (i);
+	(*elms)[i].value = build_address (get_classinfo_decl (bcd));
+      }
+
+    tree type = build_array_type (ptr_type_node,
+				  build_index_type (size_int (depth)));
+    tree decl = build_artificial_decl (type, build_constructor (type, elms));
+    TREE_READONLY (decl) = 1;
+    DECL_EXTERNAL (decl) = 0;
+    d_pushdecl (decl);
+
+    tree value = d_array_value (array_type_node, size_int (depth + 1),
+				build_address (decl));
+    this->layout_field (value);
+  }
+
   /* Write out the interfacing vtable[] of base class BCD that will be accessed
      from the overriding class CD.  If both are the same class, then this will
      be it's own vtable.  INDEX is the offset in the interfaces array of the
@@ -722,6 +955,7 @@ public:
 	OffsetTypeInfo[] m_offTi;
 	void function(Object) defaultConstructor;
 	immutable(void)* m_RTInfo;
+	immutable(TypeInfo_Class)[] m_ancestors;
 
      Information relating to interfaces, and their vtables are layed out
      immediately after the named fields, if there is anything to write.  */
@@ -844,10 +1078,15 @@ public:
 	  this->layout_field (null_pointer_node);
 
 	/* immutable(void)* m_RTInfo;  */
-	if (cd->getRTInfo)
-	  this->layout_field (build_expr (cd->getRTInfo, true));
+	if (Expression *rtinfo = aggregate_rtinfo (cd))
+	  this->layout_field (build_expr (rtinfo, true));
 	else if (!(flags & ClassFlags::noPointers))
-	  this->layout_field (size_one_node);
+	  this->layout_field (build_pointer_bitmap (cd));
+	else
+	  this->layout_field (null_pointer_node);
+
+	/* immutable(TypeInfo_Class)[] m_ancestors;  */
+	this->layout_ancestors (cd);
       }
     else
       {
@@ -893,6 +1132,9 @@ public:
 	  this->layout_field (build_expr (cd->getRTInfo, true));
 	else
 	  this->layout_field (null_pointer_node);
+
+	/* immutable(TypeInfo_Class)[] m_ancestors;  (interfaces have none)  */
+	this->layout_field (null_array_node);
       }
 
     /* Put out array of Interfaces.  */
@@ -1039,10 +1281,10 @@ public:
       }
 
     /* immutable(void)* xgetRTInfo;  */
-    if (sd->getRTInfo)
-      this->layout_field (build_expr (sd->getRTInfo, true));
+    if (Expression *rtinfo = aggregate_rtinfo (sd))
+      this->layout_field (build_expr (rtinfo, true));
     else if (m_flags & StructFlags::hasPointers)
-      this->layout_field (size_one_node);
+      this->layout_field (build_pointer_bitmap (sd));
   }
 
   /* Layout of TypeInfo_Tuple is:
@@ -1086,6 +1328,8 @@ public:
 tree
 layout_typeinfo (TypeInfoDeclaration *d)
 {
+  tinfo_emitted[get_typeinfo_kind (d->tinfo)]++;
+
   tree type = TREE_TYPE (get_typeinfo_decl (d));
   TypeInfoVisitor v = TypeInfoVisitor (type);
   d->accept (&v);
@@ -1098,6 +1342,8 @@ layout_typeinfo (TypeInfoDeclaration *d)
 tree
 layout_classinfo (ClassDeclaration *cd)
 {
+  tinfo_emitted[TK_CLASSINFO_TYPE]++;
+
   TypeInfoClassDeclaration *d = TypeInfoClassDeclaration::create (cd->type);
   tree type = TREE_TYPE (get_classinfo_decl (cd));
   TypeInfoVisitor v = TypeInfoVisitor (type);
@@ -1218,6 +1464,17 @@ public:
   }
 };
 
+static bool builtin_typeinfo_p (Type *);
+
+/* Returns TRUE if TypeInfo is only written out once it is referenced by
+   the generated code, rather than whenever the front-end asks for it.  */
+
+static bool
+minimal_typeinfo_p (void)
+{
+  return flag_typeinfo == typeinfo_emit_minimal;
+}
+
 /* Get the VAR_DECL of the TypeInfo for DECL.  If this does not yet exist,
    create it.  The TypeInfo decl provides information about the type of a given
    expression or object.  */
@@ -1234,6 +1491,12 @@ get_typeinfo_decl (TypeInfoDeclaration *decl)
   decl->accept (&v);
   gcc_assert (decl->csym != NULL_TREE);
 
+  /* This is the first reference to the TypeInfo, so now is the time to
+     write it out if create_typeinfo didn't.  */
+  if (minimal_typeinfo_p () && decl->semanticRun < PASSobj
+      && !builtin_typeinfo_p (decl->tinfo))
+    build_decl_tree (decl);
+
   return decl->csym;
 }
 
@@ -1524,9 +1787,12 @@ create_typeinfo (Type *type, Module *mod)
 	}
       gcc_assert (t->vtinfo);
 
+      tinfo_requested[tk]++;
+
       /* If this has a custom implementation in rt/typeinfo, then
-	 do not generate a COMDAT for it.  */
-      if (!builtin_typeinfo_p (t))
+	 do not generate a COMDAT for it.  With -ftypeinfo=minimal, it
+	 is instead generated by get_typeinfo_decl when first referenced.  */
+      if (!builtin_typeinfo_p (t) && !minimal_typeinfo_p ())
 	{
 	  /* Find module that will go all the way to an object file.  */
 	  if (mod)
@@ -1542,6 +1808,33 @@ create_typeinfo (Type *type, Module *mod)
   gcc_assert (type->vtinfo != NULL);
 }
 
+/* Print the number of TypeInfo declarations of each kind that were asked
+   for and written out for -fdump-d-typeinfo.  TypeInfo for the built-in
+   types is in the runtime library, so is never written out.  */
+
+void
+dump_typeinfo_stats (void)
+{
+  unsigned requested = 0;
+  unsigned emitted = 0;
+
+  fprintf (global.stdmsg, "%-28s %9s %9s\n", "typeinfo",
+	   "requested", "emitted");
+
+  for (int i = 0; i < TK_END; i++)
+    {
+      if (tinfo_requested[i] == 0 && tinfo_emitted[i] == 0)
+	continue;
+
+      fprintf (global.stdmsg, "  %-26s %9u %9u\n", tinfo_names[i],
+	       tinfo_requested[i], tinfo_emitted[i]);
+      requested += tinfo_requested[i];
+      emitted += tinfo_emitted[i];
+    }
+
+  fprintf (global.stdmsg, "  %-26s %9u %9u\n", "total", requested, emitted);
+}
+
 /* Implements a visitor interface to check whether a type is speculative.
    TypeInfo_Struct would refer the members of the struct it is representing
    (e.g. opEquals via xopEquals field), so if it's instantiated in speculative